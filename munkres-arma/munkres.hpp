@@ -23,19 +23,81 @@
 #pragma once
 
 #include <armadillo>
+#include <algorithm>
+#include <bitset>
 #include <cassert>
-#include <list>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Optional GPU backend, build munkres_cuda.cu with nvcc and link it in.
+#if defined(MUNKRES_USE_CUDA)
+#include "munkres_cuda.hpp"
+#endif
+
+// Per-solve counters and timings, see munkres<eT>::stats(). Without
+// MUNKRES_ENABLE_STATS they are compiled out entirely.
+#if defined(MUNKRES_ENABLE_STATS)
+#define MUNKRES_STATS(statement) statement
+#else
+#define MUNKRES_STATS(statement)
+#endif
+
+// Runtime CPU dispatch for the scan kernels: GCC builds one clone per
+// instruction set and picks one at load time (needs ifunc, i.e. glibc).
+// Elsewhere the kernels are compiled for the target of the build, which
+// includes NEON on AArch64. Define it as empty to turn the clones off.
+#if !defined(MUNKRES_TARGET_CLONES)
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define MUNKRES_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define MUNKRES_TARGET_CLONES
+#endif
+#endif
 
 namespace arma
 {
+	//! Integer modulus for mod(), elementwise and without the round trip through double
+	template <typename vec_type, bool integer = std::numeric_limits<typename vec_type::elem_type>::is_integer>
+	struct mod_integer
+	{
+		static bool apply(const vec_type&, typename vec_type::elem_type, vec_type&)
+		{
+			return false;
+		}
+	};
+
+	template <typename vec_type>
+	struct mod_integer<vec_type, true>
+	{
+		static bool apply(const vec_type& X, typename vec_type::elem_type Y, vec_type& M)
+		{
+			typedef typename vec_type::elem_type elem_type;
+
+			M.set_size(X.n_rows, X.n_cols);
+			for (uword i = 0; i < X.n_elem; i++) {
+				elem_type r = X[i] % Y;
+				if (r != 0 && ((r < 0) != (Y < 0)))
+					r += Y; // the sign of Y, as for floor division
+				M[i] = r;
+			}
+
+			return true;
+		}
+	};
+
 	//! Modulus after division
 	template <typename vec_type>
 	inline vec_type mod(const vec_type& X, typename vec_type::elem_type Y)
 	{
-		typedef typename vec_type::elem_type elem_type;
 		assert(Y != 0);
 		
 		vec_type M;
+		if (mod_integer<vec_type>::apply(X, Y, M))
+			return M;
+
 		switch (X.vec_state) {
 		case 0: // matrix
 			M = X - arma::conv_to<vec_type>::from(
@@ -51,158 +113,2294 @@ namespace arma
 		return M;
 	}
 
-	arma::umat ind2sub(const arma::SizeMat& siz, const arma::uvec& ndx)
-	{
-		arma::umat sub(ndx.size(), 2);
-		sub.col(0) = mod(ndx, siz.n_rows);
-		sub.col(1) = ndx / siz.n_rows;
-		return sub;
+	inline arma::umat ind2sub(const arma::SizeMat& siz, const arma::uvec& ndx)
+	{
+		arma::umat sub(ndx.size(), 2);
+		sub.col(0) = mod(ndx, siz.n_rows);
+		sub.col(1) = ndx / siz.n_rows;
+		return sub;
+	}
+
+	template <typename mat_type>
+	inline mat_type sortrows(const mat_type& X, uword col)
+	{
+		return X.rows(arma::stable_sort_index(X.col(col)));
+	}
+};
+
+/*!
+ * Type of the potentials and the cost sums for eT costs: eT itself for
+ * floating point and 64-bit integers, 64 bits for narrower integers, so that
+ * 32-bit or 16-bit cost matrices can not overflow them.
+ */
+template <typename eT, bool narrow = std::numeric_limits<eT>::is_integer && (sizeof(eT) < 8)>
+struct munkres_accumulator
+{
+	typedef eT type;
+};
+
+template <typename eT>
+struct munkres_accumulator<eT, true>
+{
+	typedef arma::s64 type;
+};
+
+/*!
+ * munkres<eT> solves problems of any size at run time, munkres<eT, N> is a
+ * fixed-size solver for tiny N x N problems (see below).
+ */
+template <typename eT, arma::uword N = 0>
+class munkres;
+
+template <typename eT>
+class munkres<eT, 0>
+{
+public:
+	typedef arma::uword		size_type;
+
+	//! Potentials and cost sums, see munkres_accumulator
+	typedef typename munkres_accumulator<eT>::type	acc_type;
+
+	//! Marks a row without a column in state_type
+	static const size_type NONE = static_cast<size_type>(-1);
+
+	//! Solver engines, selectable per solve() call
+	enum method_type {
+		STEPS,			//!< classic step-based Munkres, kept as the reference engine
+		STEPS_SLACK,	//!< step-based Munkres with incremental slacks and lazy dual offsets
+		SHORTEST_PATH,	//!< row/column potentials with shortest augmenting paths, O(n^3)
+		AUCTION			//!< Bertsekas' auction with epsilon scaling, bids in parallel with OpenMP
+	};
+
+	/*!
+	 * Final assignment and dual potentials of a solve, indexed like the cost
+	 * matrix: col_of_row(i) is the column of row i (or NONE), row_dual(i) and
+	 * col_dual(j) the potentials of row i and column j. Passed back in, it seeds
+	 * the next solve.
+	 */
+	struct state_type {
+		arma::uvec		col_of_row;
+		arma::Col<acc_type>	row_dual;
+		arma::Col<acc_type>	col_dual;
+	};
+
+#if defined(MUNKRES_ENABLE_STATS)
+	/*!
+	 * What the last solve did. The step engines count their steps. The shortest
+	 * path and sparse engines count an augmentation per inserted row (column)
+	 * and a dual update per Dijkstra step, the auction a dual update per
+	 * bidding round and an augmentation per phase.
+	 */
+	struct stats_type {
+		size_type	zero_searches;		//!< step3 runs
+		size_type	augmentations;		//!< step4 runs or inserted rows
+		size_type	dual_updates;		//!< step5 runs, Dijkstra steps or bidding rounds
+		size_type	path_length;		//!< summed length of the augmenting paths
+		size_type	max_path_length;	//!< longest augmenting path
+		size_type	generated_rows;		//!< rows produced by the generator of solve_rows
+		double		prepare_time;		//!< seconds for the set-up, infinities and reduction
+		double		solve_time;			//!< seconds for the main loop and the result
+	};
+
+	typedef std::function<void (const stats_type&)>	stats_callback_type;
+
+	const stats_type& stats() const
+	{
+		return stats_;
+	}
+
+	/*!
+	 * Called with the stats at the end of every solve, e.g. to feed a metrics
+	 * or tracing system. The threads of a batch solve share it, so it has to
+	 * be thread safe.
+	 */
+	void set_stats_callback(const stats_callback_type& callback)
+	{
+		stats_callback_ = callback;
+	}
+#endif
+
+	/*!
+	 * The settings of a solver, apart from the workspace. The set_* functions
+	 * below change single fields. A config can be handed to the constructor
+	 * or configure(), or shared read-only between threads that each solve on
+	 * their own workspace (see munkres_pool.hpp).
+	 */
+	struct config_type {
+		eT			tolerance;			//!< see set_tolerance
+		int			threads;			//!< see set_threads
+		size_type	parallel_threshold;	//!< see set_threads
+		size_type	row_cache;			//!< see set_row_cache
+		double		auction_bound;		//!< see set_auction_bound
+		size_type	gpu_threshold;		//!< see set_gpu_threshold
+
+		config_type()
+			: tolerance(0), threads(1), parallel_threshold(256 * 256), row_cache(1 << 20),
+			auction_bound(0), gpu_threshold(1024 * 1024)
+		{
+		}
+	};
+
+	munkres()
+		: matrix_(NULL), slack_mode_(false), slack_valid_(false)
+	{
+	}
+
+	explicit munkres(const config_type& config)
+		: matrix_(NULL), slack_mode_(false), slack_valid_(false)
+	{
+		configure(config);
+	}
+
+	const config_type& config() const
+	{
+		return config_;
+	}
+
+	//! Take over all settings of config, the workspace stays as it is
+	void configure(const config_type& config)
+	{
+		config_ = config;
+		config_.threads = std::max(config.threads, 1);
+	}
+
+	/*!
+	 * With MUNKRES_USE_CUDA, SHORTEST_PATH solves of at least elements entries
+	 * (or batches of that many entries in total) run on the GPU. Smaller ones,
+	 * and all of them if no device is available, stay on the CPU. Every problem
+	 * runs on a single thread block, so the device is worth it for batches
+	 * rather than for one large problem.
+	 */
+	void set_gpu_threshold(size_type elements)
+	{
+		config_.gpu_threshold = elements;
+	}
+
+	/*!
+	 * Let AUCTION stop early: the total cost of its result is then at most bound
+	 * above the optimum. With bound <= 0 (the default) integer costs are solved
+	 * exactly and floating point costs to about 1e-9 of their range. Larger
+	 * bounds skip the last epsilon scaling phases. Integer costs whose range
+	 * times n^2 reaches 2^49 are too wide for the double bids and are solved
+	 * by SHORTEST_PATH instead.
+	 */
+	void set_auction_bound(double bound)
+	{
+		config_.auction_bound = bound;
+	}
+
+	/*!
+	 * Entries of the reduced matrix up to tol count as zeros in the step
+	 * engines. With floating point costs the reductions can leave residues
+	 * like 1e-17 where an exact computation has a zero, which costs extra
+	 * step3 / step5 rounds. A tolerance a little above the rounding error of
+	 * the costs (e.g. 1e-9 times their magnitude) lets those problems take the
+	 * same path as exact ones. The default 0 still treats tiny negative
+	 * residues as zeros. Integer costs are exact and need no tolerance.
+	 */
+	void set_tolerance(eT tol)
+	{
+		config_.tolerance = tol;
+	}
+
+	/*!
+	 * Split the min-reduction and the zero and minimum searches of the step
+	 * engines across up to n threads, for matrices of at least threshold
+	 * elements. Needs OpenMP, without it or with n = 1 (the default) they run
+	 * serially.
+	 */
+	void set_threads(int n, size_type threshold = 256 * 256)
+	{
+		config_.threads = std::max(n, 1);
+		config_.parallel_threshold = threshold;
+	}
+
+	arma::umat solve(const arma::Mat<eT>& m, method_type method = STEPS)
+	{
+		arma::umat assignments;
+		solve(m, assignments, method);
+		return assignments;
+	}
+
+	/*!
+	 * Same as above, but the (row, column) pairs are written to assignments.
+	 * The solver keeps its buffers between calls, so reusing one solver and one
+	 * assignments matrix for problems that fit into earlier (or reserved) sizes
+	 * solves without any heap allocation.
+	 */
+	void solve(const arma::Mat<eT>& m, arma::umat& assignments, method_type method = STEPS)
+	{
+		if (m.is_empty()) {
+			assignments.set_size(0, 2);
+			return;
+		}
+
+		// The auction would pad a rectangular problem with identical zero-cost
+		// persons, whose price war dwarfs the real bids.
+		if (method == AUCTION && m.n_rows != m.n_cols)
+			method = SHORTEST_PATH;
+
+		if (method == SHORTEST_PATH) {
+			// Every row gets a column, so the shorter dimension has to be the rows.
+			const bool transposed = m.n_rows > m.n_cols;
+
+#if defined(MUNKRES_USE_CUDA)
+			if (m.n_elem >= config_.gpu_threshold) {
+				// the device takes the problem column major
+				arma::Mat<eT> work(workspace(m.n_elem),
+					transposed ? m.n_cols : m.n_rows, transposed ? m.n_rows : m.n_cols, false, true);
+
+				if (transposed)
+					work = m.t();
+				else
+					work = m;
+
+				if (solve_device(work, transposed, assignments))
+					return;
+			}
+#endif
+
+			// Row major: the engine scans one row (of the shorter dimension) at a time.
+			arma::Mat<eT> work(workspace(m.n_elem),
+				std::max(m.n_rows, m.n_cols), std::min(m.n_rows, m.n_cols), false, true);
+
+			if (transposed)
+				work = m;
+			else
+				work = m.t();
+
+			solve_shortest_path(work, true, transposed, assignments);
+			return;
+		}
+
+		if (method == AUCTION) {
+			arma::Mat<eT> work(workspace(m.n_elem), m.n_rows, m.n_cols, false, true);
+			work = m;
+
+			solve_auction(work, assignments);
+			return;
+		}
+
+		// filled by the first preparation pass
+		arma::Mat<eT> work(workspace(m.n_elem), m.n_rows, m.n_cols, false, true);
+
+		solve_steps(m, work, method, assignments);
+	}
+
+	/*!
+	 * Same as above, but assignment(i) receives the column of row i (NONE for
+	 * the rows left over when there are more rows than columns) and the total
+	 * cost is returned, summed over the entries of m in acc_type. Both are
+	 * taken straight from the engine's pairs, in O(min(rows, cols)).
+	 */
+	acc_type solve(const arma::Mat<eT>& m, arma::uvec& assignment, method_type method = STEPS)
+	{
+		solve(m, pairs_, method);
+
+		assignment.set_size(m.n_rows);
+		assignment.fill(NONE);
+
+		acc_type total = 0;
+		for ( size_type k = 0 ; k < pairs_.n_rows ; k++ ) {
+			const size_type row = pairs_.at(k, 0),
+				col = pairs_.at(k, 1);
+
+			assignment[row] = col;
+			total += m.at(row, col);
+		}
+
+		return total;
+	}
+
+	/*!
+	 * Shortest path solve on costs produced one row at a time, for problems too
+	 * large to hold (e.g. rows of a memory-mapped file, see munkres_mmap.hpp).
+	 * generator(i, out) writes the cols entries of row i to out; it is called
+	 * again for a row whenever the engine scans it. Apart from the generator
+	 * the solver keeps O(rows + cols) state. With more rows than columns each
+	 * row is padded with zero-cost dummy columns, and rows matched to a dummy
+	 * stay unassigned. Infinities stand for the largest finite entry, which is
+	 * found by one extra pass over all rows when the first one is generated;
+	 * finite costs are generated only as the engine scans them.
+	 */
+	template <typename generator_type>
+	void solve_rows(size_type rows, size_type cols, const generator_type& generator, arma::umat& assignments)
+	{
+		if (rows == 0 || cols == 0) {
+			assignments.set_size(0, 2);
+			return;
+		}
+
+		const size_type columns = std::max(rows, cols);
+
+		MUNKRES_STATS(stats_begin());
+
+		// The solver must not keep the generator past this call, also when it throws.
+		generator_guard guard(*this);
+
+		row_generator_ = std::cref(generator); // held by reference, it need not be copyable
+		generated_rows_ = rows;
+		generated_cols_ = cols;
+		row_buffer_.assign(columns, 0);
+		col_step_ = 1;
+		row_fill_known_ = false;
+
+		// Rows the engine scans again come from the cache, up to config_.row_cache entries.
+		const size_type slots = std::min(rows, config_.row_cache / columns);
+		row_cache_.assign(slots * columns, 0);
+		cache_tag_.assign(slots, NONE);
+
+		if ( rows <= cols )
+			shortest_path(rows, columns, false, assignments, NULL);
+		else {
+			shortest_path(rows, columns, false, pairs_, NULL);
+
+			assignments.set_size(cols, 2);
+			for ( size_type k = 0, n = 0 ; k < pairs_.n_rows ; k++ ) {
+				if ( pairs_.at(k, 1) < cols ) {
+					assignments.at(n, 0) = pairs_.at(k, 0);
+					assignments.at(n, 1) = pairs_.at(k, 1);
+					n++;
+				}
+			}
+		}
+	}
+
+	/*!
+	 * Shortest path solve on costs given by a functor, cost(i, j) returning the
+	 * entry of row i and column j, so no cost matrix is ever built. Rows are
+	 * evaluated as the engine scans them and kept in the row cache (see
+	 * set_row_cache), so the functor runs about once per entry when the cache
+	 * holds all rows. If one returns an infinity, every entry is evaluated once
+	 * more to find the largest finite one.
+	 */
+	template <typename function_type>
+	void solve(size_type rows, size_type cols, const function_type& cost, arma::umat& assignments)
+	{
+		solve_rows(rows, cols, cost_rows<function_type>(cost, cols), assignments);
+	}
+
+	template <typename function_type>
+	arma::umat solve(size_type rows, size_type cols, const function_type& cost)
+	{
+		arma::umat assignments;
+		solve(rows, cols, cost, assignments);
+		return assignments;
+	}
+
+	/*!
+	 * Number of cost entries solve_rows() and the functor form of solve() may
+	 * keep to avoid regenerating rows the engine scans again (default 2^20, 8 MB
+	 * of doubles). 0 turns the cache off.
+	 */
+	void set_row_cache(size_type elements)
+	{
+		config_.row_cache = elements;
+	}
+
+	/*!
+	 * Warm-started solve with the shortest path engine. state holds the result of
+	 * an earlier solve on a similar matrix (or is empty for a cold start) and is
+	 * overwritten with the new one. Seeded pairs that are still tight under the
+	 * new costs are kept and only the remaining rows are augmented, so frames
+	 * that change little cost a few augmentations instead of a full solve.
+	 *
+	 * The state is matched by index: entries beyond the new size are dropped and
+	 * new rows or columns start fresh. When rows or columns are removed or
+	 * inserted in the middle, do the same to the state vectors (shed_row,
+	 * insert_rows) and set col_of_row entries pointing at removed columns to
+	 * NONE (or shift them) before the next call.
+	 */
+	void solve(const arma::Mat<eT>& m, arma::umat& assignments, state_type& state)
+	{
+		if (m.is_empty()) {
+			assignments.set_size(0, 2);
+			state.col_of_row.set_size(m.n_rows);
+			state.col_of_row.fill(NONE);
+			state.row_dual.zeros(m.n_rows);
+			state.col_dual.zeros(m.n_cols);
+			return;
+		}
+
+		const bool transposed = m.n_rows > m.n_cols;
+
+		// Row major, as in solve()
+		arma::Mat<eT> work(workspace(m.n_elem),
+			std::max(m.n_rows, m.n_cols), std::min(m.n_rows, m.n_cols), false, true);
+
+		if (transposed)
+			work = m;
+		else
+			work = m.t();
+
+		solve_shortest_path(work, true, transposed, assignments, &state);
+	}
+
+	arma::umat solve(const arma::Mat<eT>& m, state_type& state)
+	{
+		arma::umat assignments;
+		solve(m, assignments, state);
+		return assignments;
+	}
+
+	/*!
+	 * Solve on the caller's matrix without copying it. m is used as the working
+	 * matrix and is left reduced, i.e. its contents are unspecified afterwards.
+	 */
+	void solve_inplace(arma::Mat<eT>& m, arma::umat& assignments, method_type method = STEPS)
+	{
+		if (m.is_empty()) {
+			assignments.set_size(0, 2);
+			return;
+		}
+
+		if (method == STEPS || method == STEPS_SLACK)
+			solve_steps(m, m, method, assignments);
+		else if (method == SHORTEST_PATH || m.n_rows != m.n_cols)
+			solve_shortest_path(m, m.n_rows > m.n_cols, m.n_rows > m.n_cols, assignments);
+		else
+			solve_auction(m, assignments);
+	}
+
+	arma::umat solve_inplace(arma::Mat<eT>& m, method_type method = STEPS)
+	{
+		arma::umat assignments;
+		solve_inplace(m, assignments, method);
+		return assignments;
+	}
+
+	//! In-place solve on rows x cols column-major memory owned by the caller
+	arma::umat solve_inplace(eT* mem, size_type rows, size_type cols, method_type method = STEPS)
+	{
+		arma::Mat<eT> m(mem, rows, cols, false, true);
+		return solve_inplace(m, method);
+	}
+
+	/*!
+	 * Sparse assignment: only the stored entries of m are feasible pairs, a
+	 * missing entry can never be assigned (so zero costs have to be stored as a
+	 * small positive value or shifted away). The work is proportional to the
+	 * entries the augmenting paths reach, not to rows * cols. If not every row
+	 * (or column, whichever is fewer) can be matched through stored entries, the
+	 * cheapest of the largest possible matchings is returned.
+	 */
+	arma::umat solve(const arma::SpMat<eT>& m)
+	{
+		arma::umat assignments;
+		solve(m, assignments);
+		return assignments;
+	}
+
+	void solve(const arma::SpMat<eT>& m, arma::umat& assignments)
+	{
+		// Columns are the sources and are all assigned if possible, so there must
+		// not be more of them than rows.
+		if (m.n_cols > m.n_rows) {
+			const arma::SpMat<eT> t = m.t();
+			solve_sparse(t, true, assignments);
+		}
+		else
+			solve_sparse(m, false, assignments);
+	}
+
+	/*!
+	 * Batch solve: every slice of problems is an independent assignment problem
+	 * and gets its own entry in assignments. One solver per thread is reused for
+	 * all problems of that thread, so after the first few problems no buffers are
+	 * allocated anymore. Built with OpenMP, the batch is spread across up to
+	 * threads threads, otherwise it is solved sequentially.
+	 */
+	void solve(const arma::Cube<eT>& problems, arma::field<arma::umat>& assignments,
+		method_type method = STEPS, int threads = 1)
+	{
+#if defined(MUNKRES_USE_CUDA)
+		if (method == SHORTEST_PATH && problems.n_elem > 0 && problems.n_elem >= config_.gpu_threshold &&
+			solve_device(problems, assignments))
+			return;
+#endif
+
+		solve_batch(problems, problems.n_slices, assignments, method, threads);
+	}
+
+	arma::field<arma::umat> solve(const arma::Cube<eT>& problems, method_type method = STEPS, int threads = 1)
+	{
+		arma::field<arma::umat> assignments;
+		solve(problems, assignments, method, threads);
+		return assignments;
+	}
+
+	//! Same as above for a list of problems that may differ in size
+	void solve(const arma::field<arma::Mat<eT> >& problems, arma::field<arma::umat>& assignments,
+		method_type method = STEPS, int threads = 1)
+	{
+		solve_batch(problems, problems.n_elem, assignments, method, threads);
+	}
+
+	arma::field<arma::umat> solve(const arma::field<arma::Mat<eT> >& problems, method_type method = STEPS, int threads = 1)
+	{
+		arma::field<arma::umat> assignments;
+		solve(problems, assignments, method, threads);
+		return assignments;
+	}
+
+	/*!
+	 * Gated solve: the finite entries of m are the feasible pairs, and the rows
+	 * and columns they link form independent blocks (the connected components
+	 * of the bipartite graph of feasible pairs). Each block is solved on its
+	 * own, spread across up to threads threads as in the batch solve, and the
+	 * rows and columns left over are paired with each other. The result is an
+	 * optimal assignment of m with the infinities replaced as in solve(), in
+	 * the same row-sorted format, so a gated 5000 x 5000 matrix of 50 blocks
+	 * costs 50 small solves. Matrices without infinities are a single block and
+	 * go straight to solve().
+	 */
+	void solve_blocks(const arma::Mat<eT>& m, arma::umat& assignments, method_type method = STEPS, int threads = 1)
+	{
+		const size_type rows = m.n_rows,
+			cols = m.n_cols;
+
+		if (m.is_empty() || !std::numeric_limits<eT>::has_infinity) {
+			solve(m, assignments, method);
+			return;
+		}
+
+		// union-find over the rows [0, rows) and the columns [rows, rows + cols)
+		component_.resize(rows + cols);
+		for ( size_type k = 0 ; k < rows + cols ; k++ )
+			component_[k] = k;
+
+		eT fill = eT(0);
+		size_type feasible = 0;
+		for ( size_type col = 0 ; col < cols ; col++ ) {
+			const eT* p = m.colptr(col);
+			for ( size_type row = 0 ; row < rows ; row++ ) {
+				if ( arma::is_finite(p[row]) ) {
+					fill = feasible == 0 || p[row] > fill ? p[row] : fill;
+					feasible++;
+
+					const size_type a = find_component(row),
+						b = find_component(rows + col);
+					if ( a != b )
+						component_[a < b ? b : a] = a < b ? a : b;
+				}
+			}
+		}
+
+		if (feasible == m.n_elem) {
+			solve(m, assignments, method);
+			return;
+		}
+
+		// number the blocks in order of their first row (or column)
+		std::vector<size_type> block_of(rows + cols), first(1, 0), members;
+		std::vector<size_type> block_rows, block_cols;
+		size_type blocks = 0;
+		{
+			std::vector<size_type> label(rows + cols, NONE);
+			for ( size_type k = 0 ; k < rows + cols ; k++ ) {
+				const size_type root = find_component(k);
+				if ( label[root] == NONE ) {
+					label[root] = blocks++;
+					block_rows.push_back(0);
+					block_cols.push_back(0);
+				}
+
+				block_of[k] = label[root];
+				if ( k < rows )
+					block_rows[block_of[k]]++;
+				else
+					block_cols[block_of[k]]++;
+			}
+		}
+
+		if (blocks == 1) {
+			solve(m, assignments, method);
+			return;
+		}
+
+		// members of block b at [first[b], first[b + 1]), rows then columns, ascending
+		first.resize(blocks + 1);
+		for ( size_type b = 0 ; b < blocks ; b++ )
+			first[b + 1] = first[b] + block_rows[b] + block_cols[b];
+
+		members.resize(rows + cols);
+		{
+			std::vector<size_type> next(first.begin(), first.end() - 1);
+			for ( size_type k = 0 ; k < rows + cols ; k++ )
+				members[next[block_of[k]]++] = k;
+		}
+
+		// blocks with both rows and columns, the infeasible entries at the fill
+		// value the whole matrix would get
+		std::vector<size_type> solved;
+		for ( size_type b = 0 ; b < blocks ; b++ ) {
+			if ( block_rows[b] > 0 && block_cols[b] > 0 )
+				solved.push_back(b);
+		}
+
+		arma::field<arma::Mat<eT> > problems(solved.size());
+		for ( size_type k = 0 ; k < solved.size() ; k++ ) {
+			const size_type b = solved[k];
+			const size_type* block_row = &members[first[b]];
+			const size_type* block_col = block_row + block_rows[b];
+
+			arma::Mat<eT>& problem = problems(k);
+			problem.set_size(block_rows[b], block_cols[b]);
+			for ( size_type col = 0 ; col < block_cols[b] ; col++ ) {
+				const eT* p = m.colptr(block_col[col] - rows);
+				for ( size_type row = 0 ; row < block_rows[b] ; row++ ) {
+					const eT v = p[block_row[row]];
+					problem.at(row, col) = arma::is_finite(v) ? v : fill;
+				}
+			}
+		}
+
+		arma::field<arma::umat> results;
+		solve(problems, results, method, threads);
+
+		// back to the rows and columns of m
+		std::vector<size_type> col_of_row(rows, NONE);
+		std::vector<unsigned char> col_taken(cols, 0);
+		for ( size_type k = 0 ; k < solved.size() ; k++ ) {
+			const size_type b = solved[k];
+			const size_type* block_row = &members[first[b]];
+			const size_type* block_col = block_row + block_rows[b];
+
+			for ( size_type n = 0 ; n < results(k).n_rows ; n++ ) {
+				const size_type col = block_col[results(k).at(n, 1)] - rows;
+				col_of_row[block_row[results(k).at(n, 0)]] = col;
+				col_taken[col] = 1;
+			}
+		}
+
+		// Left over rows and columns only meet in infeasible entries, which all
+		// cost the fill value, so any pairing of them is optimal.
+		for ( size_type row = 0, col = 0 ; row < rows ; row++ ) {
+			if ( col_of_row[row] != NONE )
+				continue;
+
+			while ( col < cols && col_taken[col] )
+				col++;
+
+			if ( col == cols )
+				break;
+
+			col_of_row[row] = col;
+			col_taken[col] = 1;
+		}
+
+		assignments.set_size(std::min(rows, cols), 2);
+		for ( size_type row = 0, n = 0 ; row < rows ; row++ ) {
+			if ( col_of_row[row] != NONE ) {
+				assignments.at(n, 0) = row;
+				assignments.at(n, 1) = col_of_row[row];
+				n++;
+			}
+		}
+	}
+
+	arma::umat solve_blocks(const arma::Mat<eT>& m, method_type method = STEPS, int threads = 1)
+	{
+		arma::umat assignments;
+		solve_blocks(m, assignments, method, threads);
+		return assignments;
+	}
+
+	/*!
+	 * Preallocate the workspace for problems of up to rows x cols, with the
+	 * current thread count. This covers every engine of solve(m, assignments,
+	 * method), and sparse solves with no more columns than rows and up to
+	 * nonzeros stored entries; wider sparse matrices are transposed into a new
+	 * SpMat first. solve_blocks() and the batch solves still allocate their
+	 * blocks and per-thread solvers.
+	 */
+	void reserve(size_type rows, size_type cols, size_type nonzeros = 0)
+	{
+		const size_type size = std::max(rows, cols);
+
+		if (storage_.size() < rows * cols)
+			storage_.resize(rows * cols);
+
+		star_in_row_.reserve(size);
+		star_in_col_.reserve(size);
+		prime_in_row_.reserve(size);
+		path_.reserve(2 * size + 1);
+		row_mask_.reserve(size);
+		col_mask_.reserve(size);
+		row_floor_.reserve(size);
+		reopened_.reserve(size);
+		col_zero_.reserve(size);
+
+		// one entry per OpenMP chunk, at most one chunk per thread
+		minimum_.reserve(config_.threads * size);
+		chunk_min_.reserve(config_.threads);
+		chunk_max_.reserve(config_.threads);
+		chunk_flag_.reserve(config_.threads);
+		chunk_row_.reserve(config_.threads);
+		chunk_col_.reserve(config_.threads);
+
+		slack_.reserve(size);
+		slack_col_.reserve(size);
+		row_offset_.reserve(size);
+		col_offset_.reserve(size);
+
+		row_dual_.reserve(rows + cols);
+		col_dual_.reserve(size + 1);
+		min_slack_.reserve(size + 1);
+		row_of_col_.reserve(size + 1);
+		col_way_.reserve(size + 1);
+		col_used_.reserve(size + 1);
+
+		col_of_row_.reserve(rows + cols);
+		row_way_.reserve(rows + cols);
+		distance_.reserve(rows + cols);
+		row_done_.reserve(rows + cols);
+		touched_.reserve(rows + cols);
+		scanned_.reserve(cols);
+		heap_.reserve(nonzeros + cols); // one push per relaxed entry, at most
+
+		price_.reserve(size);
+		best_bid_.reserve(size);
+		bid_.reserve(size);
+		owner_.reserve(size);
+		best_bidder_.reserve(size);
+		object_of_.reserve(size);
+		bid_object_.reserve(size);
+		unassigned_.reserve(size);
+
+		component_.reserve(rows + cols);
+	}
+
+private:
+	//! Representative of k in component_, halving the paths on the way
+	size_type find_component(size_type k)
+	{
+		while ( component_[k] != k ) {
+			component_[k] = component_[component_[k]];
+			k = component_[k];
+		}
+
+		return k;
+	}
+
+	static const arma::Mat<eT>& problem(const arma::Cube<eT>& problems, size_type k)
+	{
+		return problems.slice(k);
+	}
+
+	static const arma::Mat<eT>& problem(const arma::field<arma::Mat<eT> >& problems, size_type k)
+	{
+		return problems(k);
+	}
+
+	template <typename batch_type>
+	void solve_batch(const batch_type& problems, size_type count, arma::field<arma::umat>& assignments,
+		method_type method, int threads)
+	{
+		assignments.set_size(count);
+
+#if defined(_OPENMP)
+		if (threads > 1 && count > 1) {
+			// OpenMP 2.0 (MSVC) only takes signed loop indices.
+			const int n = static_cast<int>(count);
+
+			#pragma omp parallel num_threads(threads)
+			{
+				munkres<eT> local(config_);
+				MUNKRES_STATS(local.stats_callback_ = stats_callback_);
+
+				#pragma omp for schedule(dynamic)
+				for ( int k = 0 ; k < n ; k++ )
+					local.solve(problem(problems, k), assignments(k), method);
+			}
+			return;
+		}
+#else
+		(void)threads;
+#endif
+
+		for ( size_type k = 0 ; k < count ; k++ )
+			solve(problem(problems, k), assignments(k), method);
+	}
+
+#if defined(MUNKRES_USE_CUDA)
+	//! Shortest path solve of work (no more rows than columns) on the GPU
+	bool solve_device(arma::Mat<eT>& work, bool transposed, arma::umat& assignments)
+	{
+		MUNKRES_STATS(stats_begin());
+
+		matrix_ = &work;
+		replace_infinities();
+		matrix_ = NULL;
+
+		MUNKRES_STATS(stats_prepared());
+
+		device_result_.resize(work.n_rows);
+		if (!munkres_cuda::solve(work.memptr(), work.n_rows, work.n_cols, 1, &device_result_[0]))
+			return false;
+
+		device_assignments(&device_result_[0], work.n_rows, work.n_cols, transposed, assignments);
+
+		// The kernel keeps no counters, only the inserted rows are known.
+		MUNKRES_STATS(stats_.augmentations = work.n_rows);
+		MUNKRES_STATS(stats_end());
+		return true;
+	}
+
+	//! All slices in one launch, one thread block per problem, recorded as one solve
+	bool solve_device(const arma::Cube<eT>& problems, arma::field<arma::umat>& assignments)
+	{
+		MUNKRES_STATS(stats_begin());
+
+		const bool transposed = problems.n_rows > problems.n_cols;
+		const size_type rows = std::min(problems.n_rows, problems.n_cols),
+			columns = std::max(problems.n_rows, problems.n_cols),
+			count = problems.n_slices;
+
+		eT* mem = workspace(problems.n_elem);
+		for ( size_type k = 0 ; k < count ; k++ ) {
+			arma::Mat<eT> work(mem + k * rows * columns, rows, columns, false, true);
+
+			if (transposed)
+				work = problems.slice(k).t();
+			else
+				work = problems.slice(k);
+
+			matrix_ = &work;
+			replace_infinities();
+		}
+		matrix_ = NULL;
+
+		MUNKRES_STATS(stats_prepared());
+
+		device_result_.resize(count * rows);
+		if (!munkres_cuda::solve(mem, rows, columns, count, &device_result_[0]))
+			return false;
+
+		assignments.set_size(count);
+		for ( size_type k = 0 ; k < count ; k++ )
+			device_assignments(&device_result_[k * rows], rows, columns, transposed, assignments(k));
+
+		MUNKRES_STATS(stats_.augmentations = count * rows);
+		MUNKRES_STATS(stats_end());
+		return true;
+	}
+
+	//! Assignments from the column of every working row
+	void device_assignments(const std::size_t* col_of_row, size_type rows, size_type columns,
+		bool transposed, arma::umat& assignments)
+	{
+		assignments.set_size(rows, 2);
+
+		if (transposed) {
+			// The original rows are the working columns, visited in order.
+			row_of_col_.assign(columns, NONE);
+			for ( size_type row = 0 ; row < rows ; row++ )
+				row_of_col_[col_of_row[row]] = row;
+
+			for ( size_type col = 0, k = 0 ; col < columns ; col++ ) {
+				if ( row_of_col_[col] != NONE ) {
+					assignments.at(k, 0) = col;
+					assignments.at(k, 1) = row_of_col_[col];
+					k++;
+				}
+			}
+		}
+		else {
+			for ( size_type row = 0 ; row < rows ; row++ ) {
+				assignments.at(row, 0) = row;
+				assignments.at(row, 1) = col_of_row[row];
+			}
+		}
+	}
+#endif
+
+#if defined(MUNKRES_ENABLE_STATS)
+	void stats_begin()
+	{
+		stats_ = stats_type();
+		stats_timer_.tic();
+	}
+
+	void stats_prepared()
+	{
+		stats_.prepare_time = stats_timer_.toc();
+	}
+
+	//! One augmentation along a path of length entries
+	void stats_path(size_type length)
+	{
+		stats_.augmentations++;
+		stats_.path_length += length;
+		stats_.max_path_length = std::max(stats_.max_path_length, length);
+	}
+
+	//! Counters of a solve run by another solver on our behalf, e.g. on widened costs
+	template <typename other_stats>
+	void stats_adopt(const other_stats& inner)
+	{
+		stats_.zero_searches = inner.zero_searches;
+		stats_.augmentations = inner.augmentations;
+		stats_.dual_updates = inner.dual_updates;
+		stats_.path_length = inner.path_length;
+		stats_.max_path_length = inner.max_path_length;
+		stats_.prepare_time += inner.prepare_time;
+	}
+
+	void stats_end()
+	{
+		stats_.solve_time = stats_timer_.toc() - stats_.prepare_time;
+
+		if (stats_callback_)
+			stats_callback_(stats_);
+	}
+#endif
+
+	//! Working memory for an n-element matrix, grown on demand and kept afterwards
+	eT* workspace(size_type n)
+	{
+		if (storage_.size() < n)
+			storage_.resize(n);
+
+		return &storage_[0];
+	}
+
+	void replace_infinities()
+	{
+        // If there were any infinities, replace them with a value greater
+        // than the maximum value in the matrix.
+		if (!matrix_->has_inf())
+			return;
+
+		eT* mem = matrix_->memptr();
+		const size_type n = matrix_->n_elem;
+
+		bool found = false;
+		eT value = 0;
+		for ( size_type i = 0 ; i < n ; i++ ) {
+			if ( arma::is_finite(mem[i]) && (!found || mem[i] > value) ) {
+				value = mem[i];
+				found = true;
+			}
+		}
+
+		for ( size_type i = 0 ; i < n ; i++ ) {
+			if ( !arma::is_finite(mem[i]) )
+				mem[i] = value;
+		}
+	}
+
+	/*!
+	 * Copy source into work (unless they are the same matrix), replace its
+	 * non-finite entries and reduce it, in two passes down the columns:
+	 *
+	 * 1. Copy a column and, while it is in cache, gather the row minima and the
+	 *    smallest and largest finite entry. Non-finite entries are left out.
+	 * 2. Replace the non-finite entries of a column with the largest finite one,
+	 *    subtract the row minima and then the column's own minimum.
+	 *
+	 * Only a dimension that gets fully assigned may be reduced: subtracting a
+	 * constant from a column that may stay unassigned changes the relative
+	 * assignment costs. Integer costs whose range does not fit (see fits_steps)
+	 * make it return false after the first pass, with source untouched.
+	 */
+	bool prepare(const arma::Mat<eT>& source, arma::Mat<eT>& work)
+	{
+		const size_type rows = work.n_rows,
+			columns = work.n_cols;
+		const bool reduce_rows = rows <= columns,
+			reduce_columns = columns <= rows;
+
+		const eT top = std::numeric_limits<eT>::max(),
+			bottom = std::numeric_limits<eT>::is_integer ? std::numeric_limits<eT>::min() : -top;
+
+		// Per chunk: row minima, the smallest and largest finite entry and whether
+		// any entry was not finite. Floating point costs only need the extremes
+		// for the infinities, and only gather them when there are some.
+		const int n = chunks();
+
+		minimum_.assign(reduce_rows ? n * rows : 0, top);
+		chunk_min_.assign(n, top);
+		chunk_max_.assign(n, bottom);
+		chunk_flag_.assign(n, 0);
+
+#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n) schedule(static, 1) if (n > 1)
+#endif
+		for ( int c = 0 ; c < n ; c++ ) {
+			eT* row_min = reduce_rows ? &minimum_[c * rows] : NULL;
+			bool finite = true;
+
+			for ( size_type col = chunk_begin(c, n) ; col < chunk_begin(c + 1, n) ; col++ ) {
+				const eT* p = source.colptr(col);
+				eT* q = work.colptr(col);
+
+				if ( p != q )
+					std::copy(p, p + rows, q);
+
+				finite = scan_column(q, rows, row_min, chunk_min_[c], chunk_max_[c]) && finite;
+			}
+
+			chunk_flag_[c] = !finite;
+		}
+
+		const bool finite = std::find(chunk_flag_.begin(), chunk_flag_.end(), 1) == chunk_flag_.end();
+
+		// Rare: gather everything again, leaving out what is not finite.
+		if ( !finite ) {
+#if defined(_OPENMP)
+			#pragma omp parallel for num_threads(n) schedule(static, 1) if (n > 1)
+#endif
+			for ( int c = 0 ; c < n ; c++ ) {
+				eT* row_min = reduce_rows ? &minimum_[c * rows] : NULL;
+				if ( reduce_rows )
+					std::fill(row_min, row_min + rows, top);
+
+				chunk_min_[c] = top;
+				chunk_max_[c] = bottom;
+				for ( size_type col = chunk_begin(c, n) ; col < chunk_begin(c + 1, n) ; col++ )
+					scan_column_nonfinite(work.colptr(col), rows, row_min, chunk_min_[c], chunk_max_[c]);
+			}
+		}
+
+		const eT lowest = *std::min_element(chunk_min_.begin(), chunk_min_.end()),
+			highest = *std::max_element(chunk_max_.begin(), chunk_max_.end());
+
+		if ( std::numeric_limits<eT>::is_integer && !fits_steps(lowest, highest) )
+			return false;
+
+		// The infinities become the largest finite entry, or 0 if there is none.
+		const eT fill = lowest <= highest ? highest : eT(0);
+
+		if ( reduce_rows ) {
+			for ( int c = 1 ; c < n ; c++ ) {
+				for ( size_type row = 0 ; row < rows ; row++ )
+					minimum_[row] = std::min(minimum_[row], minimum_[c * rows + row]);
+			}
+
+			// rows holding no finite entry at all
+			if ( !finite ) {
+				for ( size_type row = 0 ; row < rows ; row++ )
+					minimum_[row] = std::min(minimum_[row], fill);
+			}
+		}
+
+#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n) schedule(static) if (n > 1)
+#endif
+		for ( int col = 0 ; col < static_cast<int>(columns) ; col++ ) {
+			eT* q = work.colptr(col);
+
+			if ( !finite ) {
+				for ( size_type row = 0 ; row < rows ; row++ ) {
+					if ( !arma::is_finite(q[row]) )
+						q[row] = fill;
+				}
+			}
+
+			if ( reduce_rows ) {
+				const eT* row_min = &minimum_[0];
+				for ( size_type row = 0 ; row < rows ; row++ )
+					q[row] -= row_min[row];
+			}
+
+			if ( reduce_columns ) {
+				const eT lowest_in_col = column_minimum(q, rows);
+				for ( size_type row = 0 ; row < rows ; row++ )
+					q[row] -= lowest_in_col;
+			}
+		}
+
+		return true;
+	}
+
+	/*!
+	 * First preparation pass over one column: fold it into the row minima (if
+	 * row_min is set) and, for integers, into lowest and highest. Returns false
+	 * if an entry is not finite, the row minima may then include it.
+	 */
+	MUNKRES_TARGET_CLONES
+	static bool scan_column(const eT* p, size_type n, eT* row_min, eT& lowest, eT& highest)
+	{
+		if ( std::numeric_limits<eT>::is_integer ) {
+			eT low[8], high[8];
+			for ( size_type k = 0 ; k < 8 ; k++ ) {
+				low[k] = lowest;
+				high[k] = highest;
+			}
+
+			size_type i = 0;
+			for ( ; i + 8 <= n ; i += 8 ) {
+				for ( size_type k = 0 ; k < 8 ; k++ ) {
+					const eT v = p[i + k];
+					low[k] = v < low[k] ? v : low[k];
+					high[k] = v > high[k] ? v : high[k];
+				}
+			}
+
+			for ( ; i < n ; i++ ) {
+				low[0] = p[i] < low[0] ? p[i] : low[0];
+				high[0] = p[i] > high[0] ? p[i] : high[0];
+			}
+
+			for ( size_type k = 0 ; k < 8 ; k++ ) {
+				lowest = std::min(lowest, low[k]);
+				highest = std::max(highest, high[k]);
+			}
+
+			if ( row_min != NULL ) {
+				for ( i = 0 ; i < n ; i++ )
+					row_min[i] = p[i] < row_min[i] ? p[i] : row_min[i];
+			}
+
+			return true;
+		}
+
+		// v - v is 0 for finite v and NaN otherwise
+		unsigned bad = 0;
+		if ( row_min != NULL ) {
+			for ( size_type i = 0 ; i < n ; i++ ) {
+				const eT v = p[i];
+				row_min[i] = v < row_min[i] ? v : row_min[i];
+				bad |= !(v - v == eT(0));
+			}
+		}
+		else {
+			for ( size_type i = 0 ; i < n ; i++ )
+				bad |= !(p[i] - p[i] == eT(0));
+		}
+
+		return bad == 0;
+	}
+
+	//! scan_column() leaving out the entries that are not finite, extremes included
+	static void scan_column_nonfinite(const eT* p, size_type n, eT* row_min, eT& lowest, eT& highest)
+	{
+		for ( size_type i = 0 ; i < n ; i++ ) {
+			const eT v = p[i];
+			if ( arma::is_finite(v) ) {
+				lowest = std::min(lowest, v);
+				highest = std::max(highest, v);
+				if ( row_min != NULL )
+					row_min[i] = std::min(row_min[i], v);
+			}
+		}
+	}
+
+	//! Smallest of p[0, n), n > 0, in eight independent lanes
+	MUNKRES_TARGET_CLONES
+	static eT column_minimum(const eT* p, size_type n)
+	{
+		eT lane[8];
+		for ( size_type k = 0 ; k < 8 ; k++ )
+			lane[k] = p[0];
+
+		size_type i = 0;
+		for ( ; i + 8 <= n ; i += 8 ) {
+			for ( size_type k = 0 ; k < 8 ; k++ )
+				lane[k] = p[i + k] < lane[k] ? p[i + k] : lane[k];
+		}
+
+		eT h = lane[0];
+		for ( size_type k = 1 ; k < 8 ; k++ )
+			h = lane[k] < h ? lane[k] : h;
+
+		for ( ; i < n ; i++ )
+			h = p[i] < h ? p[i] : h;
+
+		return h;
+	}
+
+	/*!
+	 * Number of column chunks the scans are split into, one per thread for
+	 * large enough matrices when built with OpenMP and 1 otherwise.
+	 */
+	int chunks() const
+	{
+#if defined(_OPENMP)
+		if ( config_.threads > 1 && matrix_->n_elem >= config_.parallel_threshold )
+			return static_cast<int>(std::min<size_type>(config_.threads, matrix_->n_cols));
+#endif
+		return 1;
+	}
+
+	//! First column of chunk c out of n, chunk_begin(n, n) is the column count
+	size_type chunk_begin(int c, int n) const
+	{
+		return matrix_->n_cols * c / n;
+	}
+
+	/*!
+	 * Run the step engines on source, copied to work (which may be source
+	 * itself). Rectangular problems are solved as they are, without padding:
+	 * only the shorter dimension is reduced and the steps stop once
+	 * min(rows, columns) zeros are starred.
+	 */
+	void solve_steps(const arma::Mat<eT>& source, arma::Mat<eT>& work, method_type method, arma::umat& assignments)
+	{
+		const size_type rows = work.n_rows,
+			columns = work.n_cols,
+			size = std::min(rows, columns);
+
+		matrix_ = &work;
+		MUNKRES_STATS(stats_begin());
+
+		star_in_row_.assign(rows, NONE);
+		star_in_col_.assign(columns, NONE);
+		prime_in_row_.assign(rows, NONE);
+
+		// the longest alternating sequence has 2 * size + 1 entries
+		path_.reserve(2 * size + 1);
+
+		row_mask_.clear();
+		row_mask_.resize(rows);
+
+		col_mask_.clear();
+		col_mask_.resize(columns);
+
+		// Prepare the matrix values...
+
+		if ( !prepare(source, work) ) {
+			matrix_ = NULL;
+			solve_steps_wide(source, method, assignments);
+			return;
+		}
+
+		// In slack mode step5 never touches the matrix, the adjustments are
+		// accumulated in the offsets instead.
+		slack_mode_ = (method == STEPS_SLACK);
+		slack_valid_ = false;
+
+		if (slack_mode_) {
+			row_offset_.assign(rows, 0);
+			col_offset_.assign(columns, 0);
+			slack_.resize(rows);
+			slack_col_.resize(rows);
+		}
+
+		MUNKRES_STATS(stats_prepared());
+
+		// Follow the steps. An easy matrix is solved by step1 alone (step is 0).
+        int step = step1();
+        while ( step ) {
+            switch ( step ) {
+            case 2:
+                step = step2();
+                // step is always either 0 or 3
+                break;
+            case 3:
+                step = step3();
+                // step in [3, 4, 5]
+                break;
+            case 4:
+                step = step4();
+                // step is always 2
+                break;
+            case 5:
+                step = step5();
+                // step is always 3
+                break;
+            }
+        }
+		
+		// One star per assigned row, read out in row order.
+		assignments.set_size(size, 2);
+		for ( size_type row = 0, k = 0 ; row < rows ; row++ ) {
+			if ( star_in_row_[row] != NONE ) {
+				assignments.at(k, 0) = row;
+				assignments.at(k, 1) = star_in_row_[row];
+				k++;
+			}
+		}
+
+		MUNKRES_STATS(stats_end());
+		matrix_ = NULL;
+	}
+
+	/*!
+	 * Whether integer costs from lowest to highest can run through the step
+	 * engines in eT. The reduced entries never exceed twice the cost range (see
+	 * step5), which must fit.
+	 */
+	static bool fits_steps(eT lowest, eT highest)
+	{
+		const eT half = std::numeric_limits<eT>::max() / 2;
+
+		return lowest > 0 ? highest - lowest <= half : highest <= half + lowest;
+	}
+
+	//! Step engines on a copy of work widened to acc_type
+	void solve_steps_wide(const arma::Mat<eT>& work, method_type method, arma::umat& assignments)
+	{
+		if ( sizeof(acc_type) == sizeof(eT) )
+			throw std::overflow_error("munkres: the cost range is too wide for the element type");
+
+		arma::Mat<acc_type> wide = arma::conv_to<arma::Mat<acc_type> >::from(work);
+
+		MUNKRES_STATS(stats_prepared());
+
+		munkres<acc_type> solver;
+		solver.set_tolerance(acc_type(config_.tolerance));
+		solver.set_threads(config_.threads, config_.parallel_threshold);
+		solver.solve_inplace(wide, assignments, typename munkres<acc_type>::method_type(method));
+
+		MUNKRES_STATS(stats_adopt(solver.stats()));
+		MUNKRES_STATS(stats_end());
+	}
+
+	//! Entry (row, col) of the problem the shortest path engine works on
+	eT cost(size_type row, size_type col) const
+	{
+		return matrix_->memptr()[row * row_step_ + col * col_step_];
+	}
+
+	/*!
+	 * Row row of the problem the shortest path engine works on, entry col at
+	 * [col * col_step_]. Generated rows land in their slot of the row cache,
+	 * or in row_buffer_ without one, with their infinities replaced; past
+	 * generated_cols_ they hold the zero padding.
+	 */
+	const eT* problem_row(size_type row)
+	{
+		if ( !row_generator_ )
+			return matrix_->memptr() + row * row_step_;
+
+		return generate_row(row);
+	}
+
+	//! Generated row, from the direct mapped row cache when it holds it
+	eT* generate_row(size_type row)
+	{
+		eT* p = &row_buffer_[0];
+
+		if ( !cache_tag_.empty() ) {
+			const size_type slot = row % cache_tag_.size();
+			p = &row_cache_[slot * row_buffer_.size()];
+
+			if ( cache_tag_[slot] == row )
+				return p;
+
+			cache_tag_[slot] = row;
+		}
+
+		row_generator_(row, p);
+		MUNKRES_STATS(stats_.generated_rows++);
+
+		if ( std::numeric_limits<eT>::has_infinity ) {
+			for ( size_type col = 0 ; col < generated_cols_ ; col++ ) {
+				if ( arma::is_finite(p[col]) )
+					continue;
+
+				if ( !row_fill_known_ ) {
+					find_row_fill();
+
+					// the search generates into row_buffer_
+					if ( cache_tag_.empty() ) {
+						row_generator_(row, p);
+						MUNKRES_STATS(stats_.generated_rows++);
+					}
+				}
+
+				p[col] = row_fill_;
+			}
+		}
+
+		return p;
+	}
+
+	/*!
+	 * The largest finite generated entry (0 if there is none), which stands in
+	 * for the infinities. Rows generated before had none, so they stay valid.
+	 */
+	void find_row_fill()
+	{
+		bool found = false;
+		row_fill_ = 0;
+
+		for ( size_type row = 0 ; row < generated_rows_ ; row++ ) {
+			eT* p = &row_buffer_[0];
+			row_generator_(row, p);
+			MUNKRES_STATS(stats_.generated_rows++);
+
+			for ( size_type col = 0 ; col < generated_cols_ ; col++ ) {
+				if ( arma::is_finite(p[col]) && (!found || p[col] > row_fill_) ) {
+					row_fill_ = p[col];
+					found = true;
+				}
+			}
+		}
+
+		row_fill_known_ = true;
+	}
+
+	//! Drops the generator of solve_rows() and its row cache however the solve ends
+	struct generator_guard
+	{
+		explicit generator_guard(munkres& s) : solver(s) {}
+
+		~generator_guard()
+		{
+			solver.row_generator_ = row_generator_type();
+			solver.generated_cols_ = 0;
+			solver.cache_tag_.clear();
+		}
+
+		munkres&	solver;
+	};
+
+	//! Generator for the cost functor form of solve(), one functor call per entry
+	template <typename function_type>
+	struct cost_rows
+	{
+		cost_rows(const function_type& function, size_type n) : cost(function), cols(n) {}
+
+		void operator()(size_type row, eT* out) const
+		{
+			for ( size_type col = 0 ; col < cols ; col++ )
+				out[col] = cost(row, col);
+		}
+
+		const function_type&	cost;
+		size_type				cols;
+	};
+
+	/*!
+	 * Run the shortest path engine on work. The problem has no more rows than
+	 * columns and is stored column major in work, or row major (work is its
+	 * transpose) with row_major, which makes the row scans contiguous. With a
+	 * state, it is used as the seed and receives the final potentials.
+	 */
+	void solve_shortest_path(arma::Mat<eT>& work, bool row_major, bool transposed,
+		arma::umat& assignments, state_type* state = NULL)
+	{
+		/*
+		Shortest Augmenting Path
+
+		Rows are inserted one at a time. For each new row a Dijkstra-like search over
+		the reduced costs c(i, j) - u(i) - v(j) finds the cheapest alternating path to
+		a free column, the potentials are updated so that the path becomes tight and the
+		assignment is flipped along it. Every insertion costs O(n * m).
+		*/
+
+		const size_type rows = row_major ? work.n_cols : work.n_rows,
+			columns = row_major ? work.n_rows : work.n_cols;
+
+		matrix_ = &work;
+		row_step_ = row_major ? work.n_rows : 1;
+		col_step_ = row_major ? 1 : work.n_rows;
+
+		MUNKRES_STATS(stats_begin());
+		replace_infinities();
+
+		shortest_path(rows, columns, transposed, assignments, state);
+		matrix_ = NULL;
+	}
+
+	//! The shortest path engine proper, on the rows problem_row() gives
+	void shortest_path(size_type rows, size_type columns, bool transposed,
+		arma::umat& assignments, state_type* state)
+	{
+		const acc_type inf = std::numeric_limits<acc_type>::has_infinity ?
+			std::numeric_limits<acc_type>::infinity() : std::numeric_limits<acc_type>::max();
+
+		// The extra column (index `columns`) is a virtual root holding the row being inserted.
+		row_dual_.assign(rows, 0);
+		col_dual_.assign(columns + 1, 0);
+		row_of_col_.assign(columns + 1, NONE);
+		col_way_.assign(columns + 1, NONE);
+		col_used_.resize(columns + 1);
+		col_of_row_.assign(rows, NONE);
+
+		if (state != NULL && !state->col_of_row.is_empty())
+			seed_shortest_path(*state, rows, columns, transposed);
+		else
+			init_shortest_path(rows, columns);
+
+		MUNKRES_STATS(stats_prepared());
+
+		for ( size_type row = 0 ; row < rows ; row++ ) {
+			if ( col_of_row_[row] != NONE )
+				continue; // kept from the seed
+
+			size_type col0 = columns;
+			row_of_col_[col0] = row;
+
+			min_slack_.assign(columns + 1, inf);
+			std::fill(col_used_.begin(), col_used_.end(), false);
+
+			do {
+				col_used_[col0] = true;
+
+				const size_type row0 = row_of_col_[col0];
+				const eT* cost_row = problem_row(row0);
+				size_type col1 = columns;
+				acc_type delta = inf;
+
+				for ( size_type col = 0 ; col < columns ; col++ ) {
+					if ( !col_used_[col] ) {
+						const acc_type cur = acc_type(cost_row[col * col_step_]) - row_dual_[row0] - col_dual_[col];
+						if ( cur < min_slack_[col] ) {
+							min_slack_[col] = cur;
+							col_way_[col] = col0;
+						}
+
+						// On a tie a free column wins, it ends the search right away.
+						if ( min_slack_[col] < delta ||
+							(min_slack_[col] == delta && row_of_col_[col] == NONE && row_of_col_[col1] != NONE) ) {
+							delta = min_slack_[col];
+							col1 = col;
+						}
+					}
+				}
+
+				for ( size_type col = 0 ; col <= columns ; col++ ) {
+					if ( col_used_[col] ) {
+						row_dual_[row_of_col_[col]] += delta;
+						col_dual_[col] -= delta;
+					}
+					else
+						min_slack_[col] -= delta;
+				}
+
+				MUNKRES_STATS(stats_.dual_updates++);
+				col0 = col1;
+			} while ( row_of_col_[col0] != NONE );
+
+			// Flip the assignment along the augmenting path back to the root.
+			MUNKRES_STATS(size_type length = 0);
+			do {
+				const size_type col1 = col_way_[col0];
+				row_of_col_[col0] = row_of_col_[col1];
+				col0 = col1;
+				MUNKRES_STATS(length++);
+			} while ( col0 != columns );
+
+			MUNKRES_STATS(stats_path(length));
+		}
+
+		// Every row is assigned, so there is exactly one pair per row of the working matrix.
+		assignments.set_size(rows, 2);
+
+		if (transposed) {
+			// Columns of the transposed problem are the original rows, visited in order.
+			size_type k = 0;
+			for ( size_type col = 0 ; col < columns ; col++ ) {
+				if ( row_of_col_[col] != NONE ) {
+					assignments.at(k, 0) = col;
+					assignments.at(k, 1) = row_of_col_[col];
+					k++;
+				}
+			}
+		}
+		else {
+			for ( size_type col = 0 ; col < columns ; col++ ) {
+				const size_type row = row_of_col_[col];
+				if ( row != NONE ) {
+					assignments.at(row, 0) = row;
+					assignments.at(row, 1) = col;
+				}
+			}
+		}
+
+		if (state != NULL)
+			store_shortest_path(*state, rows, columns, transposed);
+
+		MUNKRES_STATS(stats_end());
+	}
+
+	/*!
+	 * Cold start initialisation, as in the first phase of Jonker and Volgenant's
+	 * LAPJV. A square problem gets v(j) = min c(i, j) and each column goes to its
+	 * minimum row if that row is still free, then each free row to a free column
+	 * whose minimum it shares; otherwise every row goes to its minimum column,
+	 * a free one among ties, if there is one (u(i) = min c(i, j), v = 0). Then
+	 * the reduction of each assigned row is transferred to its column: u(i)
+	 * becomes the row's second smallest reduced cost. The pairs found are tight,
+	 * so only the remaining rows need a shortest path search, and an easy matrix
+	 * is solved in O(n * m).
+	 */
+	void init_shortest_path(size_type rows, size_type columns)
+	{
+		const acc_type inf = std::numeric_limits<acc_type>::has_infinity ?
+			std::numeric_limits<acc_type>::infinity() : std::numeric_limits<acc_type>::max();
+
+		if ( rows == columns ) {
+			// Column minima, row by row; col_way_ holds the minimum rows for now.
+			std::fill(col_dual_.begin(), col_dual_.begin() + columns, inf);
+			for ( size_type row = 0 ; row < rows ; row++ ) {
+				const eT* p = problem_row(row);
+				for ( size_type col = 0 ; col < columns ; col++ ) {
+					const acc_type c = p[col * col_step_];
+					if ( c < col_dual_[col] ) {
+						col_dual_[col] = c;
+						col_way_[col] = row;
+					}
+				}
+			}
+
+			// from the last column, as LAPJV does
+			size_type matched = 0;
+			for ( size_type col = columns ; col-- > 0 ; ) {
+				const size_type row = col_way_[col];
+				if ( col_of_row_[row] == NONE ) {
+					col_of_row_[row] = col;
+					row_of_col_[col] = row;
+					matched++;
+				}
+				col_way_[col] = NONE;
+			}
+
+			// Tied minima all point at their first row, which leaves most rows of a
+			// zero heavy matrix free. Each of those takes a free column whose minimum
+			// it holds too.
+			for ( size_type row = 0 ; row < rows && matched < rows ; row++ ) {
+				if ( col_of_row_[row] != NONE )
+					continue;
+
+				const eT* p = problem_row(row);
+				for ( size_type col = 0 ; col < columns ; col++ ) {
+					if ( row_of_col_[col] == NONE && acc_type(p[col * col_step_]) == col_dual_[col] ) {
+						col_of_row_[row] = col;
+						row_of_col_[col] = row;
+						matched++;
+						break;
+					}
+				}
+			}
+		}
+		else {
+			for ( size_type row = 0 ; row < rows ; row++ ) {
+				const eT* p = problem_row(row);
+				size_type best = 0;
+				for ( size_type col = 1 ; col < columns ; col++ ) {
+					// among tied minima a free column
+					if ( p[col * col_step_] < p[best * col_step_] ||
+						(p[col * col_step_] == p[best * col_step_] && row_of_col_[col] == NONE && row_of_col_[best] != NONE) )
+						best = col;
+				}
+
+				row_dual_[row] = p[best * col_step_];
+				if ( row_of_col_[best] == NONE ) {
+					col_of_row_[row] = best;
+					row_of_col_[best] = row;
+				}
+			}
+		}
+
+		// Reduction transfer. Lowering v(j) keeps every reduced cost non-negative.
+		if ( columns < 2 )
+			return;
+
+		for ( size_type row = 0 ; row < rows ; row++ ) {
+			const size_type assigned = col_of_row_[row];
+			if ( assigned == NONE )
+				continue;
+
+			const eT* p = problem_row(row);
+			acc_type second = inf;
+			for ( size_type col = 0 ; col < columns ; col++ ) {
+				if ( col != assigned )
+					second = std::min(second, acc_type(p[col * col_step_]) - col_dual_[col]);
+			}
+
+			col_dual_[assigned] = p[assigned * col_step_] - second;
+			row_dual_[row] = second;
+		}
+	}
+
+	/*!
+	 * Turn a state from an earlier solve into feasible potentials and a partial
+	 * assignment for the working matrix. The column potentials are taken over,
+	 * the row potentials recomputed as u(i) = min c(i, j) - v(j), and seeded pairs
+	 * that are no longer tight are dropped.
+	 */
+	void seed_shortest_path(const state_type& state, size_type rows, size_type columns, bool transposed)
+	{
+		// The state is indexed like the original matrix, the working one may be its transpose.
+		const arma::Col<acc_type>& col_seed = transposed ? state.row_dual : state.col_dual;
+		for ( size_type col = 0 ; col < columns && col < col_seed.n_elem ; col++ )
+			col_dual_[col] = col_seed[col];
+
+		if (transposed) {
+			for ( size_type col = 0 ; col < columns && col < state.col_of_row.n_elem ; col++ ) {
+				const size_type row = state.col_of_row[col];
+				if ( row < rows && col_of_row_[row] == NONE ) {
+					row_of_col_[col] = row;
+					col_of_row_[row] = col;
+				}
+			}
+		}
+		else {
+			for ( size_type row = 0 ; row < rows && row < state.col_of_row.n_elem ; row++ ) {
+				const size_type col = state.col_of_row[row];
+				if ( col < columns && row_of_col_[col] == NONE ) {
+					row_of_col_[col] = row;
+					col_of_row_[row] = col;
+				}
+			}
+		}
+
+		// With more columns than rows, the unassigned columns must keep a zero
+		// potential and the others a non-positive one for the result to be optimal.
+		const bool rectangular = rows < columns;
+		if (rectangular) {
+			for ( size_type col = 0 ; col < columns ; col++ )
+				col_dual_[col] = std::min(col_dual_[col], acc_type(0));
+		}
+
+		const acc_type inf = std::numeric_limits<acc_type>::has_infinity ?
+			std::numeric_limits<acc_type>::infinity() : std::numeric_limits<acc_type>::max();
+
+		row_dual_.assign(rows, inf);
+		for ( size_type col = 0 ; col < columns ; col++ ) {
+			for ( size_type row = 0 ; row < rows ; row++ )
+				row_dual_[row] = std::min(row_dual_[row], acc_type(cost(row, col)) - col_dual_[col]);
+		}
+
+		// Drop the pairs the new costs made loose and, when rectangular, queue the
+		// free columns whose potential still has to be raised to zero.
+		touched_.clear();
+		for ( size_type col = 0 ; col < columns ; col++ ) {
+			const size_type row = row_of_col_[col];
+			if ( row != NONE && acc_type(cost(row, col)) - col_dual_[col] > row_dual_[row] ) {
+				row_of_col_[col] = NONE;
+				col_of_row_[row] = NONE;
+			}
+
+			if ( rectangular && row_of_col_[col] == NONE && col_dual_[col] < 0 )
+				touched_.push_back(col);
+		}
+
+		// Raising v(j) can only violate column j, the rows concerned lower their
+		// potential and lose their pair, which frees another column.
+		while ( !touched_.empty() ) {
+			const size_type col = touched_.back();
+			touched_.pop_back();
+
+			col_dual_[col] = 0;
+
+			for ( size_type row = 0 ; row < rows ; row++ ) {
+				if ( cost(row, col) < row_dual_[row] ) {
+					row_dual_[row] = cost(row, col);
+
+					const size_type other = col_of_row_[row];
+					if ( other != NONE ) {
+						row_of_col_[other] = NONE;
+						col_of_row_[row] = NONE;
+
+						if ( col_dual_[other] < 0 )
+							touched_.push_back(other);
+					}
+				}
+			}
+		}
+	}
+
+	//! Copy the final assignment and potentials out, indexed like the original matrix
+	void store_shortest_path(state_type& state, size_type rows, size_type columns, bool transposed) const
+	{
+		if (transposed) {
+			state.col_of_row.set_size(columns);
+			state.row_dual.set_size(columns);
+			state.col_dual.set_size(rows);
+
+			for ( size_type col = 0 ; col < columns ; col++ ) {
+				state.col_of_row[col] = row_of_col_[col];
+				state.row_dual[col] = col_dual_[col];
+			}
+
+			for ( size_type row = 0 ; row < rows ; row++ )
+				state.col_dual[row] = row_dual_[row];
+		}
+		else {
+			state.col_of_row.set_size(rows);
+			state.row_dual.set_size(rows);
+			state.col_dual.set_size(columns);
+
+			for ( size_type row = 0 ; row < rows ; row++ )
+				state.row_dual[row] = row_dual_[row];
+
+			for ( size_type col = 0 ; col < columns ; col++ ) {
+				state.col_dual[col] = col_dual_[col];
+				if ( row_of_col_[col] != NONE )
+					state.col_of_row[row_of_col_[col]] = col;
+			}
+		}
+	}
+
+	//! Run the auction on work, which is square
+	void solve_auction(arma::Mat<eT>& work, arma::umat& assignments)
+	{
+		/*
+		Auction
+
+		The columns (persons) bid for the rows (objects). An unassigned person
+		takes the object with the lowest cost plus price and raises its price by
+		the margin to the second best plus eps, outbidding its owner. Every person
+		ends up within eps of its best choice, so the total is within n * eps of
+		the optimum. Epsilon scaling runs the auction with a shrinking eps, each
+		phase starting from the prices of the last one.
+
+		Rectangular problems go to the shortest path engine (see solve()): the
+		zero-cost dummy persons padding them to a square are all alike and
+		outbid each other for every object in every phase.
+		*/
+
+		const size_type objects = work.n_rows;
+
+		matrix_ = &work;
+		MUNKRES_STATS(stats_begin());
+		replace_infinities();
+
+		const eT* mem = work.memptr();
+		eT lowest = mem[0], highest = mem[0];
+		for ( size_type i = 1 ; i < work.n_elem ; i++ ) {
+			lowest = std::min(lowest, mem[i]);
+			highest = std::max(highest, mem[i]);
+		}
+
+		const double spread = double(highest) - double(lowest);
+
+		// The bids are made in double on the costs less the lowest one. Integer
+		// costs stay exact while the rounding of bids and prices, which grow to
+		// about objects * spread, is well below the final eps; beyond that the
+		// shortest path engine, which works in acc_type, solves them instead.
+		if (std::numeric_limits<eT>::is_integer &&
+			spread * objects * (objects + 1) >= 562949953421312.0) { // 2^49
+			solve_shortest_path(work, false, false, assignments);
+			return;
+		}
+
+		auction_offset_ = lowest;
+
+		// With integer costs, n * eps < 1 makes the result exact.
+		double final_eps;
+		if (config_.auction_bound > 0)
+			final_eps = config_.auction_bound / objects;
+		else if (std::numeric_limits<eT>::is_integer)
+			final_eps = 1.0 / (objects + 1);
+		else
+			final_eps = spread * 1e-9 / objects;
+
+		if (!(final_eps > 0))
+			final_eps = 1; // all costs equal, any assignment is optimal
+
+		price_.assign(objects, 0);
+		owner_.resize(objects);
+		object_of_.resize(objects);
+		bid_object_.resize(objects);
+		bid_.resize(objects);
+		best_bid_.resize(objects);
+		best_bidder_.assign(objects, NONE);
+
+		MUNKRES_STATS(stats_prepared());
+
+		for ( double eps = std::max(spread / 2, final_eps) ; ; eps = std::max(eps / 4, final_eps) ) {
+			std::fill(owner_.begin(), owner_.end(), NONE);
+			std::fill(object_of_.begin(), object_of_.end(), NONE);
+
+			run_auction(eps);
+			MUNKRES_STATS(stats_.augmentations++);
+
+			if (eps <= final_eps)
+				break;
+		}
+
+		assignments.set_size(objects, 2);
+
+		for ( size_type object = 0 ; object < objects ; object++ ) {
+			assignments.at(object, 0) = object;
+			assignments.at(object, 1) = owner_[object];
+		}
+
+		MUNKRES_STATS(stats_end());
+		matrix_ = NULL;
+	}
+
+	//! Bidding rounds until every person holds an object
+	void run_auction(double eps)
+	{
+		const size_type objects = matrix_->n_rows;
+
+		for (;;) {
+			unassigned_.clear();
+			for ( size_type person = 0 ; person < objects ; person++ ) {
+				if ( object_of_[person] == NONE )
+					unassigned_.push_back(person);
+			}
+
+			if ( unassigned_.empty() )
+				break;
+
+			MUNKRES_STATS(stats_.dual_updates++);
+
+			// Jacobi rounds: all bids are made against the same prices, so they can
+			// be computed in parallel and are settled afterwards.
+			const int count = static_cast<int>(unassigned_.size());
+
+#if defined(_OPENMP)
+			const int n = chunks();
+			#pragma omp parallel for num_threads(n) schedule(static) if (n > 1)
+#endif
+			for ( int k = 0 ; k < count ; k++ )
+				bid(unassigned_[k], eps);
+
+			// The highest bid on every object wins it.
+			touched_.clear();
+			for ( int k = 0 ; k < count ; k++ ) {
+				const size_type person = unassigned_[k],
+					object = bid_object_[person];
+
+				if ( best_bidder_[object] == NONE ) {
+					touched_.push_back(object);
+					best_bidder_[object] = person;
+					best_bid_[object] = bid_[person];
+				}
+				else if ( bid_[person] > best_bid_[object] ) {
+					best_bidder_[object] = person;
+					best_bid_[object] = bid_[person];
+				}
+			}
+
+			for ( size_type k = 0 ; k < touched_.size() ; k++ ) {
+				const size_type object = touched_[k],
+					person = best_bidder_[object];
+
+				if ( owner_[object] != NONE )
+					object_of_[owner_[object]] = NONE;
+
+				owner_[object] = person;
+				object_of_[person] = object;
+				price_[object] = best_bid_[object];
+
+				best_bidder_[object] = NONE;
+			}
+		}
+	}
+
+	//! Best object of person and the price it offers for it
+	void bid(size_type person, double eps)
+	{
+		const size_type objects = matrix_->n_rows;
+		const double inf = std::numeric_limits<double>::infinity();
+
+		double best = inf, second = inf;
+		size_type object = 0;
+
+		const eT* cost = matrix_->colptr(person);
+
+		// The scan starts at the person's own index: tied persons then bid for
+		// different objects instead of all outbidding each other for the first.
+		for ( size_type k = 0, i = person ; k < objects ; k++ ) {
+			const double value = double(acc_type(cost[i]) - acc_type(auction_offset_)) + price_[i];
+			if ( value < best ) {
+				second = best;
+				best = value;
+				object = i;
+			}
+			else if ( value < second )
+				second = value;
+
+			if ( ++i == objects )
+				i = 0;
+		}
+
+		if ( second == inf )
+			second = best; // a single object
+
+		bid_object_[person] = object;
+		bid_[person] = price_[object] + (second - best) + eps;
+	}
+
+	void solve_sparse(const arma::SpMat<eT>& m, bool transposed, arma::umat& assignments)
+	{
+		/*
+		Sparse Shortest Augmenting Path
+
+		Armadillo stores the columns contiguously (CSC), so here the columns are
+		inserted one at a time. Each insertion runs Dijkstra with a binary heap over
+		the reduced costs c(i, j) - u(j) - v(i) of the stored entries only, then
+		updates the potentials so the path is tight and flips it.
+
+		Every column j also has a private dummy row rows + j, standing for "j stays
+		unassigned", at a cost K larger than any difference real entries can make.
+		Every insertion therefore succeeds, a dummy is only taken when no complete
+		matching exists, and the result is the cheapest of the largest matchings.
+		*/
+		m.sync();
+		MUNKRES_STATS(stats_begin());
+
+		const size_type rows = m.n_rows,
+			columns = m.n_cols;
+		const acc_type inf = std::numeric_limits<acc_type>::has_infinity ?
+			std::numeric_limits<acc_type>::infinity() : std::numeric_limits<acc_type>::max();
+
+		col_dual_.assign(columns, 0);
+		row_dual_.assign(rows + columns, 0);
+		row_of_col_.assign(columns, NONE);
+		col_of_row_.assign(rows + columns, NONE);
+		distance_.assign(rows + columns, inf);
+		row_way_.assign(rows + columns, NONE);
+		row_done_.assign(rows + columns, false);
+
+		// Column reduction: the cheapest entry of every column becomes tight and is
+		// taken right away if its row is still free.
+		double spread = 0, largest = 0;
+		for ( size_type col = 0 ; col < columns ; col++ ) {
+			const size_type begin = m.col_ptrs[col],
+				end = m.col_ptrs[col + 1];
+
+			if ( begin == end )
+				continue;
+
+			size_type best = begin, worst = begin;
+			for ( size_type k = begin + 1 ; k < end ; k++ ) {
+				if ( m.values[k] < m.values[best] )
+					best = k;
+				if ( m.values[k] > m.values[worst] )
+					worst = k;
+			}
+
+			col_dual_[col] = m.values[best];
+
+			spread += double(m.values[worst]) - double(m.values[best]);
+			largest = std::max(largest, std::max(std::abs(double(m.values[best])), std::abs(double(m.values[worst]))));
+
+			const size_type row = m.row_indices[best];
+			if ( col_of_row_[row] == NONE ) {
+				col_of_row_[row] = col;
+				row_of_col_[col] = row;
+			}
+		}
+
+		// An alternating path changes the real cost by less than twice the spread
+		// plus twice the largest entry, so K above that never beats a real path.
+		dummy_cost_ = acc_type(std::min(2 * (spread + largest) + 1, double(std::numeric_limits<acc_type>::max()) / 8));
+
+		MUNKRES_STATS(stats_prepared());
+
+		// A column without entries can not be reached by any path either.
+		for ( size_type col = 0 ; col < columns ; col++ ) {
+			if ( row_of_col_[col] == NONE && m.col_ptrs[col] != m.col_ptrs[col + 1] )
+				augment_sparse(m, col);
+		}
+
+		// columns matched to their dummy row stay unassigned
+		size_type count = 0;
+		for ( size_type col = 0 ; col < columns ; col++ ) {
+			if ( row_of_col_[col] < rows )
+				count++;
+		}
+
+		assignments.set_size(count, 2);
+
+		if (transposed) {
+			// Columns of the transposed problem are the original rows, visited in order.
+			for ( size_type col = 0, k = 0 ; col < columns ; col++ ) {
+				if ( row_of_col_[col] < rows ) {
+					assignments.at(k, 0) = col;
+					assignments.at(k, 1) = row_of_col_[col];
+					k++;
+				}
+			}
+		}
+		else {
+			for ( size_type row = 0, k = 0 ; row < rows ; row++ ) {
+				if ( col_of_row_[row] != NONE ) {
+					assignments.at(k, 0) = row;
+					assignments.at(k, 1) = col_of_row_[row];
+					k++;
+				}
+			}
+		}
+
+		MUNKRES_STATS(stats_end());
 	}
 
-	template <typename mat_type>
-	inline mat_type sortrows(const mat_type& X, uword col)
+	//! Insert the free column source along a shortest path
+	void augment_sparse(const arma::SpMat<eT>& m, size_type source)
 	{
-		return X.rows(arma::stable_sort_index(X.col(col)));
-	}
-};
+		const acc_type inf = std::numeric_limits<acc_type>::has_infinity ?
+			std::numeric_limits<acc_type>::infinity() : std::numeric_limits<acc_type>::max();
 
-template <typename eT>
-class munkres
-{
-	typedef arma::uword		size_type;
-	typedef arma::uchar_mat	ucmat;
+		heap_.clear();
+		touched_.clear();
+		scanned_.clear();
 
-	static const unsigned char NORMAL = 0;
-	static const unsigned char STAR	= 1;
-	static const unsigned char PRIME	= 2;
+		const size_type rows = m.n_rows;
 
-public:
-	arma::umat solve(const arma::Mat<eT>& m)
-	{
-		const size_type rows = m.n_rows, 
-			columns = m.n_cols, 
-			size = std::max(rows, columns);
+		size_type col = source, sink = NONE;
+		acc_type d = 0;
 
-		matrix_ = m;
+		for (;;) {
+			// col is reached at distance d, relax its stored entries and its dummy row
+			scanned_.push_back(std::make_pair(col, d));
 
-		if (!matrix_.is_square()) {
-			const eT value = matrix_.max();
-			matrix_.resize(size, size);
+			const size_type end = m.col_ptrs[col + 1];
+			for ( size_type k = m.col_ptrs[col] ; k <= end ; k++ ) {
+				const size_type row = k < end ? m.row_indices[k] : rows + col;
+				if ( row_done_[row] )
+					continue;
 
-			if (rows > columns)
-				matrix_.cols(columns, size - 1).fill(value);
-			else
-				matrix_.rows(rows, size - 1).fill(value);
+				const acc_type cost = k < end ? acc_type(m.values[k]) : dummy_cost_;
+				const acc_type cur = d + cost - col_dual_[col] - row_dual_[row];
+				if ( cur < distance_[row] ) {
+					if ( distance_[row] == inf )
+						touched_.push_back(row);
+
+					distance_[row] = cur;
+					row_way_[row] = col;
+
+					heap_.push_back(std::make_pair(cur, row));
+					std::push_heap(heap_.begin(), heap_.end(), std::greater<std::pair<acc_type, size_type> >());
+				}
+			}
+
+			// Closest row not settled yet, skipping stale heap entries. The source's
+			// own dummy row is always free, so this never runs dry.
+			size_type row = NONE;
+			while ( !heap_.empty() ) {
+				const std::pair<acc_type, size_type> top = heap_.front();
+				std::pop_heap(heap_.begin(), heap_.end(), std::greater<std::pair<acc_type, size_type> >());
+				heap_.pop_back();
+
+				if ( !row_done_[top.second] && top.first <= distance_[top.second] ) {
+					row = top.second;
+					break;
+				}
+			}
+
+			assert(row != NONE);
+			MUNKRES_STATS(stats_.dual_updates++);
+
+			row_done_[row] = true;
+			d = distance_[row];
+
+			if ( col_of_row_[row] == NONE ) {
+				sink = row;
+				break;
+			}
+
+			// a matched edge is tight, so its column is reached at the same distance
+			col = col_of_row_[row];
 		}
 
-		mask_.set_size(size, size);
-		mask_.fill(NORMAL);
+		// Shift the potentials so that every settled entry on the tree is tight.
+		for ( size_type k = 0 ; k < scanned_.size() ; k++ )
+			col_dual_[scanned_[k].first] += d - scanned_[k].second;
 
-		row_mask_.clear();
-		row_mask_.resize(size);
+		for ( size_type k = 0 ; k < touched_.size() ; k++ ) {
+			const size_type row = touched_[k];
+			if ( row_done_[row] )
+				row_dual_[row] -= d - distance_[row];
+		}
 
-		col_mask_.clear();
-		col_mask_.resize(size);
+		// Flip the assignment along the path back to the source.
+		MUNKRES_STATS(size_type length = 0);
+		size_type row = sink;
+		for (;;) {
+			const size_type prev = row_way_[row],
+				next = row_of_col_[prev];
 
-		// Prepare the matrix values...
+			row_of_col_[prev] = row;
+			col_of_row_[row] = prev;
+			MUNKRES_STATS(length++);
 
-        // If there were any infinities, replace them with a value greater
-        // than the maximum value in the matrix.
-		if (matrix_.has_inf())
-			matrix_.elem(find_nonfinite(matrix_)).fill(matrix_.elem(arma::find_finite(matrix_)).max());
+			if ( prev == source )
+				break;
 
-		// minimize along direction
-		matrix_.each_col() -= min(matrix_, 1);
-		matrix_.each_row() -= min(matrix_, 0);
+			row = next;
+		}
 
-		// Follow the steps
-        int step = 1;
-        while ( step ) {
-            switch ( step ) {
-            case 1:
-                step = step1();
-                // step is always 2
-                break;
-            case 2:
-                step = step2();
-                // step is always either 0 or 3
-                break;
-            case 3:
-                step = step3();
-                // step in [3, 4, 5]
-                break;
-            case 4:
-                step = step4();
-                // step is always 2
-                break;
-            case 5:
-                step = step5();
-                // step is always 3
-                break;
-            }
-        }
-		
-		// Remove the excess rows or columns that we added to fit the
-        // input to a square matrix.
-		matrix_.resize(rows, columns);
-		mask_.resize(rows, columns);
+		MUNKRES_STATS(stats_path(length));
 
-		// sort subscripts by row subscript.
-		return arma::sortrows(arma::ind2sub(arma::size(mask_), find(mask_ == STAR)), 0);
+		for ( size_type k = 0 ; k < touched_.size() ; k++ ) {
+			distance_[touched_[k]] = inf;
+			row_done_[touched_[k]] = false;
+		}
 	}
 
-private:
 	int step1()
 	{
-		const size_type rows = matrix_.n_rows,
-			columns = matrix_.n_cols;
+		/*
+		Initial Starring
+		1. Star the first zero of each column whose row has no star yet.
+		2. For each row left without a star, look for a zero (r, j) whose starred row s
+		   also has a zero in a column without a star. Move the star of s there and star
+		   (r, j). Each row s is examined at most once, since the columns without a star
+		   only get fewer, so this stays O(n * m).
+		If every row or column ends up starred, the matrix is already solved.
+		*/
 
-		for ( size_type row = 0 ; row < rows ; row++ ) {
-			for ( size_type col = 0 ; col < columns ; col++ ) {
-				if ( 0 == matrix_.at(row, col) ) {
-					bool starred = false;
-					for ( size_type nrow = 0 ; nrow < rows ; nrow++ ) {
-						if ( STAR == mask_.at(nrow, col) ) {
-							starred = true;
-							break;
-						}
-					}
+		const size_type rows = matrix_->n_rows,
+			columns = matrix_->n_cols;
+		size_type starred = 0;
 
-					if (!starred) {
-						for ( size_type ncol = 0 ; ncol < columns ; ncol++ ) {
-							if ( STAR == mask_.at(row, ncol) ) {
-								starred = true;
-								break;
-							}
-						}
-					}
+		// down the columns, in storage order
+		for ( size_type col = 0 ; col < columns ; col++ ) {
+			const eT* p = matrix_->colptr(col);
+			for ( size_type row = 0 ; row < rows ; row++ ) {
+				if ( p[row] <= config_.tolerance && star_in_row_[row] == NONE ) {
+					star_in_row_[row] = col;
+					star_in_col_[col] = row;
+					starred++;
+					break; // a column holds at most one star
+				}
+			}
+		}
 
-					if (!starred)
-						mask_.at(row, col) = STAR;
+		// row_mask_ marks the rows examined by the second pass, it is cleared again below.
+		const size_type size = std::min(rows, columns);
+		for ( size_type row = 0 ; row < rows && starred < size ; row++ ) {
+			if ( star_in_row_[row] != NONE )
+				continue;
+
+			for ( size_type col = 0 ; col < columns ; col++ ) {
+				const size_type other = star_in_col_[col];
+				if ( matrix_->at(row, col) > config_.tolerance || other == NONE || row_mask_[other] )
+					continue; // no zero lies in a column without a star, the first pass took those
+
+				row_mask_[other] = true;
+
+				size_type free = 0;
+				while ( free < columns &&
+					(star_in_col_[free] != NONE || matrix_->at(other, free) > config_.tolerance) )
+					free++;
+
+				if ( free < columns ) {
+					star_in_row_[other] = free;
+					star_in_col_[free] = other;
+					star_in_row_[row] = col;
+					star_in_col_[col] = row;
+					starred++;
+					break;
 				}
 			}
 		}
 
-		return 2;
+		std::fill(row_mask_.begin(), row_mask_.end(), false);
+
+		return starred < size ? 2 : 0;
 	}
 
 	int step2()
 	{
-		const size_type rows = matrix_.n_rows,
-			columns = matrix_.n_cols;
+		const size_type columns = matrix_->n_cols;
 		size_type covercount = 0;
 
-		for ( size_type row = 0 ; row < rows ; row++ ) {
-			for ( size_type col = 0 ; col < columns ; col++ ) {
-				if ( STAR == mask_.at(row, col) ) {
-					col_mask_[col] = true;
-					covercount++;
-				}
+		// new covers, the zero search starts over
+		zero_cursor_ = 0;
+		reopened_.clear();
+
+		for ( size_type col = 0 ; col < columns ; col++ ) {
+			if ( star_in_col_[col] != NONE ) {
+				col_mask_[col] = true;
+				covercount++;
 			}
 		}
 
 		
-		if ( covercount >= min(size(matrix_)) ) {
+		if ( covercount >= min(size(*matrix_)) ) {
 #ifdef _DEBUG
 			std::cout << "Final cover count: " << covercount << std::endl;
 #endif
@@ -210,8 +2408,8 @@ private:
 		}
 
 #ifdef _DEBUG
-		std::cout << "Munkres matrix has " << covercount << " of " << min(size(matrix_)) << " columns covered:" << std::endl;
-		std::cout << matrix_ << std::endl;
+		std::cout << "Munkres matrix has " << covercount << " of " << min(size(*matrix_)) << " columns covered:" << std::endl;
+		std::cout << *matrix_ << std::endl;
 #endif
 
 		return 3;
@@ -226,18 +2424,28 @@ private:
 		3. If a Z* exists, cover this row and uncover the column of the Z*. Return to Step 3.1 to find a new Z
 		*/
 
-		if (find_uncovered(0, saverow_, savecol_))
-			mask_.at(saverow_, savecol_) = PRIME; // prime it.
+		MUNKRES_STATS(stats_.zero_searches++);
+
+		const bool found = slack_mode_ ?
+			find_uncovered_slack(saverow_, savecol_) :
+			find_uncovered(config_.tolerance, saverow_, savecol_);
+
+		if (found)
+			prime_in_row_[saverow_] = savecol_; // prime it.
 		else
 			return 5;
 
-		for ( size_type col = 0 ; col < matrix_.n_cols ; col++ ) {
-			if ( mask_.at(saverow_, col) == STAR ) {
-				row_mask_[saverow_]	= true;  //cover this row and
-				col_mask_[col]		= false; // uncover the column containing the starred zero
+		const size_type col = star_in_row_[saverow_];
+		if ( col != NONE ) {
+			row_mask_[saverow_]	= true;  //cover this row and
+			col_mask_[col]		= false; // uncover the column containing the starred zero
 
-				return 3; // repeat
-			}
+			if (slack_mode_)
+				update_slack(col);
+			else if ( col < zero_cursor_ )
+				reopened_.push_back(col); // behind the cursor, searched separately
+
+			return 3; // repeat
 		}
 
 		return 4; // no starred zero in the row containing this primed zero
@@ -245,19 +2453,11 @@ private:
 
 	int step4()
 	{
-		const size_type rows = matrix_.n_rows,
-			columns = matrix_.n_cols;
-
-		// seq contains pairs of row/column values where we have found
-		// either a star or a prime that is part of the ``alternating sequence``.
-		std::list<std::pair<int, int> > seq;
+		// path_ holds the row/column pairs of the ``alternating sequence``,
+		// primes at even and stars at odd positions.
+		path_.clear();
 		// use saverow, savecol from step 3.
-		std::pair<int, int> z0(saverow_, savecol_);
-		seq.insert(seq.end(), z0);
-
-		// We have to find these two pairs:
-		std::pair<int, int> z1(-1, -1);
-		std::pair<int, int> z2n(-1, -1);
+		path_.push_back(std::make_pair(saverow_, savecol_));
 
 		size_type row, col = savecol_;
 		/*
@@ -271,138 +2471,600 @@ private:
 			Z[2N+1] : The Z* in the column of Z[2N]
 
 		The sequence eventually terminates with an unpaired Z' = Z[2N] for some N.
+		A column holds at most one Z* and a row at most one Z', so every link is
+		a single lookup and the sequence can not revisit an entry.
 		*/
-		bool madepair;
-		do {
-			madepair = false;
-			for ( row = 0 ; row < rows ; row++ ) {
-				if ( mask_.at(row, col) == STAR ) {
-					z1.first = row;
-					z1.second = col;
-					
-					if ( pair_in_list(z1, seq) )
-						continue;
-
-					madepair = true;
-					seq.insert(seq.end(), z1);
-					break;
-				}
-			}
-
-			if ( !madepair )
-				break;
+		while ( (row = star_in_col_[col]) != NONE ) {
+			path_.push_back(std::make_pair(row, col));
 
-			madepair = false;
-
-			for ( col = 0 ; col < columns ; col++ ) {
-				if ( mask_.at(row, col) == PRIME ) {
-					z2n.first = row;
-					z2n.second = col;
-
-					if ( pair_in_list(z2n, seq) )
-						continue;
-
-					madepair = true;
-					seq.insert(seq.end(), z2n);
-					break;
-				}
-			}
-		} while ( madepair );
+			// the Z* column was uncovered by step3, which primed its row
+			col = prime_in_row_[row];
+			assert(col != NONE);
+			path_.push_back(std::make_pair(row, col));
+		}
 
-		std::for_each(seq.begin(), seq.end(), [&](std::pair<int, int>& p) {
-			// 2. Unstar each starred zero of the sequence.
-			if ( mask_.at(p.first, p.second) == STAR )
-				mask_.at(p.first, p.second) = NORMAL;
+		// 2. Unstar each starred zero of the sequence and
+		// 3. star each primed zero of the sequence, thus increasing the number of
+		// starred zeros by one. Every Z* shares its column with the Z' before it and
+		// its row with the Z' after it, so starring the primes overwrites the stars.
+		for ( size_type k = 0 ; k < path_.size() ; k += 2 ) {
+			star_in_row_[path_[k].first] = path_[k].second;
+			star_in_col_[path_[k].second] = path_[k].first;
+		}
 
-			// 3. Star each primed zero of the sequence,
-			// thus increasing the number of starred zeros by one.
-			if ( mask_.at(p.first, p.second) == PRIME )
-				mask_.at(p.first, p.second) = STAR;
-		});
+		MUNKRES_STATS(stats_path(path_.size()));
 
 		// 4. Erase all primes, uncover all columns and rows,
-		mask_.elem(arma::find(mask_ == PRIME)).fill(NORMAL);
+		std::fill(prime_in_row_.begin(), prime_in_row_.end(), NONE);
 
 		std::fill(row_mask_.begin(), row_mask_.end(), false);
 		std::fill(col_mask_.begin(), col_mask_.end(), false);
 
+		// the covers change completely, so the slacks are rebuilt on the next step3
+		slack_valid_ = false;
+
 		// and return to Step 2.
 		return 2;
 	}
 
 	int step5()
 	{
-		const size_type rows = matrix_.n_rows,
-			columns = matrix_.n_cols;
+		const size_type rows = matrix_->n_rows,
+			columns = matrix_->n_cols;
 
 		/*
 		New Zero Manufactures
 
-		1. Let h be the smallest uncovered entry in the (modified) distance matrix_.
+		1. Let h be the smallest uncovered entry in the (modified) distance matrix.
 		2. Add h to all covered rows.
 		3. Subtract h from all uncovered columns
 		4. Return to Step 3, without altering stars, primes, or covers.
+
+		Every row and every column that holds a zero keeps one, and only those
+		get covered, so an entry (i, j) can be written as c(i, j) - c(i, a) -
+		c(b, j) + c(b, a) minus a non-negative term, with zeros at (i, a) and
+		(b, j). No entry exceeds twice the cost range, which solve_steps checks
+		for integer costs: the additions below are exact and can not overflow.
 		*/
 
-		eT h = 0;
+		MUNKRES_STATS(stats_.dual_updates++);
 
-		for ( size_type row = 0 ; row < rows ; row++ ) {
-			if ( !row_mask_[row] ) {
-				for ( size_type col = 0 ; col < columns ; col++ ) {
-					if ( !col_mask_[col] ) {
-						if ( (h > matrix_.at(row, col) && matrix_.at(row, col) != 0) || h == 0 )
-							h = matrix_.at(row, col);
-					}
+		if (slack_mode_)
+			return step5_slack();
+
+		// Covered rows are lifted to the limit, so the kernels can take a plain
+		// minimum over whole columns. The reduced matrix is non-negative and has
+		// no uncovered zero at this point, the result is the smallest non-zero.
+		const eT limit = std::numeric_limits<eT>::has_infinity ?
+			std::numeric_limits<eT>::infinity() : std::numeric_limits<eT>::max();
+
+		row_floor_.resize(rows);
+		for ( size_type row = 0 ; row < rows ; row++ )
+			row_floor_[row] = row_mask_[row] ? limit : eT(0);
+
+		// Smallest uncovered entry of each chunk of columns, then over the chunks.
+		const int n = chunks();
+		chunk_min_.resize(n);
+
+#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n) schedule(static, 1) if (n > 1)
+#endif
+		for ( int c = 0 ; c < n ; c++ )
+			chunk_min_[c] = uncovered_minimum(chunk_begin(c, n), chunk_begin(c + 1, n));
+
+		eT h = chunk_min_[0];
+
+		for ( int c = 1 ; c < n ; c++ )
+			h = std::min(h, chunk_min_[c]);
+
+		// Both updates in one pass down the columns: every entry gets the term of
+		// its row (h when covered) minus the term of its column (h when uncovered).
+		for ( size_type row = 0 ; row < rows ; row++ )
+			row_floor_[row] = row_mask_[row] ? h : eT(0);
+
+		// The sweep also flags the uncovered columns that got a new zero, the only
+		// uncovered zeros there are, so the next search starts at the first of them.
+		col_zero_.resize(columns);
+
+#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n) schedule(static) if (n > 1)
+#endif
+		for ( int col = 0 ; col < static_cast<int>(columns) ; col++ ) {
+			eT* p = matrix_->colptr(col);
+			const eT* add = &row_floor_[0];
+			const unsigned char* mask = &row_mask_[0];
+
+			if ( col_mask_[col] ) {
+				for ( size_type row = 0 ; row < rows ; row++ )
+					p[row] += add[row];
+				col_zero_[col] = 0;
+			}
+			else {
+				unsigned char hit = 0;
+				for ( size_type row = 0 ; row < rows ; row++ ) {
+					p[row] += add[row] - h;
+					hit |= (p[row] <= config_.tolerance) & (mask[row] == 0);
 				}
+				col_zero_[col] = hit;
 			}
 		}
 
+		zero_cursor_ = std::find(col_zero_.begin(), col_zero_.end(), 1) - col_zero_.begin();
+		reopened_.clear();
+
+		return 3;
+	}
+
+	int step5_slack()
+	{
+		const size_type rows = matrix_->n_rows,
+			columns = matrix_->n_cols;
+
+		// The slack of an uncovered row is its smallest uncovered entry, so h is
+		// found in O(n) and is strictly positive since step3 found no zero.
+		eT h = std::numeric_limits<eT>::max();
+
+		for ( size_type row = 0 ; row < rows ; row++ ) {
+			if ( !row_mask_[row] && slack_[row] < h )
+				h = slack_[row];
+		}
+
+		// Covered rows against uncovered columns cancel out, covered rows against
+		// covered columns are never read before step4 rebuilds the slacks, so only
+		// the uncovered rows' slacks move.
 		for ( size_type row = 0 ; row < rows ; row++ ) {
 			if ( row_mask_[row] )
-				matrix_.row(row) += h;
+				row_offset_[row] += h;
+			else
+				slack_[row] -= h;
 		}
 
 		for ( size_type col = 0 ; col < columns ; col++ ) {
 			if ( !col_mask_[col] )
-				matrix_.col(col) -= h;
+				col_offset_[col] -= h;
 		}
 
 		return 3;
 	}
 
-	inline bool pair_in_list(const std::pair<int,int> &needle, const std::list<std::pair<int,int> > &haystack) const
+	//! Entry of the reduced matrix with the lazy step5 adjustments applied
+	inline eT reduced(size_type row, size_type col) const
+	{
+		return matrix_->at(row, col) + row_offset_[row] + col_offset_[col];
+	}
+
+	//! Fold the uncovered column col into the slacks of the uncovered rows
+	void update_slack(size_type col)
+	{
+		const size_type rows = matrix_->n_rows;
+
+		for ( size_type row = 0 ; row < rows ; row++ ) {
+			if ( !row_mask_[row] ) {
+				const eT value = reduced(row, col);
+				if ( value < slack_[row] ) {
+					slack_[row] = value;
+					slack_col_[row] = col;
+				}
+			}
+		}
+	}
+
+	bool find_uncovered_slack(size_type& row, size_type& col)
+	{
+		const size_type rows = matrix_->n_rows,
+			columns = matrix_->n_cols;
+
+		// Within one augmentation rows only get covered and columns only get
+		// uncovered, so the minimum over the uncovered columns only ever moves
+		// down and can be kept up to date in O(n) per event.
+		if ( !slack_valid_ ) {
+			std::fill(slack_.begin(), slack_.end(), std::numeric_limits<eT>::max());
+
+			for ( size_type ncol = 0 ; ncol < columns ; ncol++ ) {
+				if ( !col_mask_[ncol] )
+					update_slack(ncol);
+			}
+
+			slack_valid_ = true;
+		}
+
+		for ( row = 0 ; row < rows ; row++ ) {
+			if ( !row_mask_[row] && slack_[row] <= config_.tolerance ) {
+				col = slack_col_[row];
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	//! Smallest uncovered entry in columns [begin, end), using row_floor_
+	eT uncovered_minimum(size_type begin, size_type end) const
 	{
-		return std::find(haystack.begin(), haystack.end(), needle) != haystack.end();
+		const size_type rows = matrix_->n_rows;
+
+		eT h = std::numeric_limits<eT>::has_infinity ?
+			std::numeric_limits<eT>::infinity() : std::numeric_limits<eT>::max();
+
+		for ( size_type col = begin ; col < end ; col++ ) {
+			if ( !col_mask_[col] )
+				h = masked_minimum(matrix_->colptr(col), &row_floor_[0], rows, h);
+		}
+
+		return h;
+	}
+
+	/*!
+	 * Minimum of h and max(p[i], floor[i]) over n entries. The eight independent
+	 * lanes let the compiler vectorize the reduction without reassociating it.
+	 */
+	MUNKRES_TARGET_CLONES
+	static eT masked_minimum(const eT* p, const eT* floor, size_type n, eT h)
+	{
+		eT lane[8];
+		for ( size_type k = 0 ; k < 8 ; k++ )
+			lane[k] = h;
+
+		size_type i = 0;
+		for ( ; i + 8 <= n ; i += 8 ) {
+			for ( size_type k = 0 ; k < 8 ; k++ ) {
+				const eT v = p[i + k] > floor[i + k] ? p[i + k] : floor[i + k];
+				lane[k] = v < lane[k] ? v : lane[k];
+			}
+		}
+
+		for ( size_type k = 0 ; k < 8 ; k++ )
+			h = lane[k] < h ? lane[k] : h;
+
+		for ( ; i < n ; i++ ) {
+			const eT v = p[i] > floor[i] ? p[i] : floor[i];
+			h = v < h ? v : h;
+		}
+
+		return h;
+	}
+
+	/*!
+	 * Index of the first p[i] <= zero with mask[i] clear, or n. Blocks of 32 are
+	 * tested without branches, only the block with a hit is searched one by one.
+	 */
+	MUNKRES_TARGET_CLONES
+	static size_type find_unmasked(const eT* p, const unsigned char* mask, size_type n, eT zero)
+	{
+		size_type i = 0;
+		for ( ; i + 32 <= n ; i += 32 ) {
+			unsigned hit = 0;
+			for ( size_type k = 0 ; k < 32 ; k++ )
+				hit |= (p[i + k] <= zero) & (mask[i + k] == 0);
+
+			if ( hit )
+				break;
+		}
+
+		for ( ; i < n ; i++ ) {
+			if ( p[i] <= zero && !mask[i] )
+				return i;
+		}
+
+		return n;
+	}
+
+	/*!
+	 * An uncovered entry up to zero (the tolerance). Between two step4 calls rows
+	 * only get covered, so a column searched without success stays so until it
+	 * is uncovered or step5 changes the matrix. The search resumes at
+	 * zero_cursor_, with the columns step3 uncovered behind it checked first,
+	 * and each step3 costs amortised O(n) instead of rescanning the covered
+	 * prefix. From the cursor on, the first match is in column major order:
+	 * every chunk looks for its own first match and the lowest chunk with a
+	 * match wins, so the result does not depend on the thread count.
+	 */
+	bool find_uncovered(const eT zero, size_type& row, size_type& col)
+	{
+		const size_type rows = matrix_->n_rows,
+			columns = matrix_->n_cols;
+
+		while ( !reopened_.empty() ) {
+			col = reopened_.back();
+			row = find_unmasked(matrix_->colptr(col), &row_mask_[0], rows, zero);
+			if ( row < rows )
+				return true; // kept, the column may hold more
+
+			reopened_.pop_back();
+		}
+
+		const int n = chunks();
+		const size_type begin = zero_cursor_;
+
+		if ( n == 1 ) {
+			const bool found = find_uncovered(zero, begin, columns, row, col);
+			zero_cursor_ = col;
+			return found;
+		}
+
+		chunk_row_.resize(n);
+		chunk_col_.resize(n);
+
+#if defined(_OPENMP)
+		#pragma omp parallel for num_threads(n) schedule(static, 1)
+#endif
+		for ( int c = 0 ; c < n ; c++ ) {
+			const size_type first = begin + (columns - begin) * c / n,
+				last = begin + (columns - begin) * (c + 1) / n;
+
+			if ( !find_uncovered(zero, first, last, chunk_row_[c], chunk_col_[c]) )
+				chunk_col_[c] = NONE;
+		}
+
+		for ( int c = 0 ; c < n ; c++ ) {
+			if ( chunk_col_[c] != NONE ) {
+				row = chunk_row_[c];
+				col = chunk_col_[c];
+				zero_cursor_ = col;
+				return true;
+			}
+		}
+
+		zero_cursor_ = columns;
+		return false;
 	}
 
-	inline bool find_uncovered(const eT item, size_type& row, size_type& col) const
+	//! First uncovered entry up to zero in columns [begin, end)
+	inline bool find_uncovered(const eT zero, size_type begin, size_type end, size_type& row, size_type& col) const
 	{
-		const size_type rows = matrix_.n_rows,
-			columns = matrix_.n_cols;
+		const size_type rows = matrix_->n_rows;
 
 		// adjusted to column major ordering
-		for ( col = 0 ; col < columns ; col++ ) {
+		for ( col = begin ; col < end ; col++ ) {
 			if ( !col_mask_[col] ) {
-				for ( row = 0 ; row < rows ; row++ ) {
-					if ( !row_mask_[row] ) {
-						if ( matrix_.at(row, col) == item )
-							return true;
-					}
-				}
+				row = find_unmasked(matrix_->colptr(col), &row_mask_[0], rows, zero);
+				if ( row < rows )
+					return true;
 			}
 		}
 
 		return false;
 	}
 
-	arma::Mat<eT>		matrix_;
-	ucmat				mask_;
+	// the matrix being reduced, a view on storage_ for the duration of a solve
+	arma::Mat<eT>*		matrix_;
+	std::vector<eT>		storage_;
+	std::vector<eT>		minimum_;
+
+	// parallel scans: per-chunk results
+	std::vector<eT>		chunk_min_;
+	std::vector<eT>		chunk_max_;
+	std::vector<unsigned char>	chunk_flag_;
+	std::vector<size_type>	chunk_row_;
+	std::vector<size_type>	chunk_col_;
+
+	// column of the Z* / Z' in each row and row of the Z* in each column, or NONE
+	std::vector<size_type>	star_in_row_;
+	std::vector<size_type>	star_in_col_;
+	std::vector<size_type>	prime_in_row_;
+
+	// alternating sequence buffer for step4, kept across calls
+	std::vector<std::pair<size_type, size_type> >	path_;
+
+	// engine output behind the vector form of solve()
+	arma::umat			pairs_;
 	
-	std::vector<bool>	row_mask_;
-	std::vector<bool>	col_mask_;
+	// cover flags, one byte each so the kernels can read them without bit tests,
+	// and the per-row term of step5 (the floor of the minimum kernel, then the
+	// update of the covered rows)
+	std::vector<unsigned char>	row_mask_;
+	std::vector<unsigned char>	col_mask_;
+	std::vector<eT>		row_floor_;
 
 	size_type			saverow_;
 	size_type			savecol_;
+
+	// resumable zero search: uncovered columns before the cursor hold no uncovered
+	// zero, except those listed in reopened_; col_zero_ flags step5's new zeros
+	size_type			zero_cursor_;
+	std::vector<size_type>	reopened_;
+	std::vector<unsigned char>	col_zero_;
+
+	// slack mode state: per-row minimum over the uncovered columns and the lazy
+	// offsets step5 would otherwise add to the matrix
+	bool				slack_mode_;
+	bool				slack_valid_;
+	std::vector<eT>		slack_;
+	std::vector<size_type>	slack_col_;
+	std::vector<eT>		row_offset_;
+	std::vector<eT>		col_offset_;
+
+	// shortest augmenting path state
+	std::vector<acc_type>	row_dual_;
+	std::vector<acc_type>	col_dual_;
+	std::vector<acc_type>	min_slack_;
+
+	std::vector<size_type>	row_of_col_;
+	std::vector<size_type>	col_way_;
+	size_type			row_step_;
+	size_type			col_step_;
+
+	// rows from solve_rows() instead of matrix_, generated into row_buffer_
+	typedef std::function<void (size_type, eT*)>	row_generator_type;
+
+	row_generator_type	row_generator_;
+	std::vector<eT>		row_buffer_;
+	size_type			generated_rows_;
+	size_type			generated_cols_;
+	eT					row_fill_;
+	bool				row_fill_known_;	// set once the first infinity is generated
+
+	// direct mapped row cache: slot k holds row cache_tag_[k] (or NONE)
+	std::vector<eT>		row_cache_;
+	std::vector<size_type>	cache_tag_;
+	std::vector<bool>	col_used_;
+
+	// sparse shortest path state
+	std::vector<size_type>	col_of_row_;
+	std::vector<size_type>	row_way_;
+	std::vector<acc_type>	distance_;
+	std::vector<bool>	row_done_;
+	std::vector<size_type>	touched_;
+	std::vector<std::pair<size_type, acc_type> >	scanned_;
+	std::vector<std::pair<acc_type, size_type> >	heap_;
+	acc_type			dummy_cost_;
+
+	// auction state, per object (rows) and per person (columns)
+	std::vector<double>	price_;
+	std::vector<double>	best_bid_;
+	std::vector<double>	bid_;
+	std::vector<size_type>	owner_;
+	std::vector<size_type>	best_bidder_;
+	std::vector<size_type>	object_of_;
+	std::vector<size_type>	bid_object_;
+	std::vector<size_type>	unassigned_;
+	eT					auction_offset_;	// lowest cost, subtracted in the bids
+
+#if defined(MUNKRES_ENABLE_STATS)
+	stats_type			stats_;
+	stats_callback_type	stats_callback_;
+	arma::wall_clock	stats_timer_;
+#endif
+
+#if defined(MUNKRES_USE_CUDA)
+	// the device's column per row
+	std::vector<std::size_t>	device_result_;
+#endif
+
+	// union-find parents of solve_blocks, rows first, then columns
+	std::vector<size_type>	component_;
+
+	// tolerance, threads, cache and backend settings, see config_type
+	config_type			config_;
+};
+
+template <typename eT>
+const typename munkres<eT, 0>::size_type munkres<eT, 0>::NONE;
+
+/*!
+ * Fixed-size solver for N x N problems, meant for N up to about 16. All state
+ * lives on the stack and every loop runs over the compile-time N, so a solve
+ * does not allocate and the compiler can unroll. It runs the same shortest
+ * augmenting path algorithm as munkres<eT>::SHORTEST_PATH.
+ */
+template <typename eT, arma::uword N>
+class munkres
+{
+public:
+	typedef arma::uword		size_type;
+
+	//! Potentials and cost sums, see munkres_accumulator
+	typedef typename munkres_accumulator<eT>::type	acc_type;
+
+	typedef typename arma::Mat<eT>::template fixed<N, N>	matrix_type;
+	typedef arma::umat::fixed<N, 2>		result_type;
+
+	//! m must be N x N, typically a matrix_type
+	result_type solve(const arma::Mat<eT>& m)
+	{
+		result_type assignments;
+		solve(m, assignments);
+		return assignments;
+	}
+
+	void solve(const arma::Mat<eT>& m, result_type& assignments)
+	{
+		assert(m.n_rows == N && m.n_cols == N);
+
+		const eT* mem = m.memptr();
+		const acc_type inf = std::numeric_limits<acc_type>::has_infinity ?
+			std::numeric_limits<acc_type>::infinity() : std::numeric_limits<acc_type>::max();
+
+		// Local copy with the infinities replaced by the largest finite value.
+		eT cost[N * N];
+		eT largest = 0;
+		bool finite = true, found = false;
+		for ( size_type i = 0 ; i < N * N ; i++ ) {
+			cost[i] = mem[i];
+			if ( !arma::is_finite(mem[i]) )
+				finite = false;
+			else if ( !found || mem[i] > largest ) {
+				largest = mem[i];
+				found = true;
+			}
+		}
+
+		if ( !finite ) {
+			for ( size_type i = 0 ; i < N * N ; i++ ) {
+				if ( !arma::is_finite(cost[i]) )
+					cost[i] = largest;
+			}
+		}
+
+		// Column N is the virtual root holding the row being inserted.
+		acc_type row_dual[N], col_dual[N + 1], min_slack[N + 1];
+		size_type row_of_col[N + 1], col_way[N + 1];
+		std::bitset<N + 1> col_used;
+
+		for ( size_type i = 0 ; i < N ; i++ )
+			row_dual[i] = 0;
+
+		for ( size_type j = 0 ; j <= N ; j++ ) {
+			col_dual[j] = 0;
+			row_of_col[j] = N;
+		}
+
+		for ( size_type row = 0 ; row < N ; row++ ) {
+			size_type col0 = N;
+			row_of_col[col0] = row;
+
+			for ( size_type j = 0 ; j <= N ; j++ )
+				min_slack[j] = inf;
+			col_used.reset();
+
+			do {
+				col_used.set(col0);
+
+				const size_type row0 = row_of_col[col0];
+				size_type col1 = N;
+				acc_type delta = inf;
+
+				for ( size_type col = 0 ; col < N ; col++ ) {
+					if ( !col_used[col] ) {
+						const acc_type cur = acc_type(cost[col * N + row0]) - row_dual[row0] - col_dual[col];
+						if ( cur < min_slack[col] ) {
+							min_slack[col] = cur;
+							col_way[col] = col0;
+						}
+
+						if ( min_slack[col] < delta ) {
+							delta = min_slack[col];
+							col1 = col;
+						}
+					}
+				}
+
+				for ( size_type col = 0 ; col <= N ; col++ ) {
+					if ( col_used[col] ) {
+						row_dual[row_of_col[col]] += delta;
+						col_dual[col] -= delta;
+					}
+					else
+						min_slack[col] -= delta;
+				}
+
+				col0 = col1;
+			} while ( row_of_col[col0] != N );
+
+			// Flip the assignment along the augmenting path back to the root.
+			do {
+				const size_type col1 = col_way[col0];
+				row_of_col[col0] = row_of_col[col1];
+				col0 = col1;
+			} while ( col0 != N );
+		}
+
+		for ( size_type col = 0 ; col < N ; col++ ) {
+			const size_type row = row_of_col[col];
+			assignments.at(row, 0) = row;
+			assignments.at(row, 1) = col;
+		}
+	}
 };
 
 #endif /* !defined(_MUNKRES_HPP_) */
\ No newline at end of file
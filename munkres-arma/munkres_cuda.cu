@@ -0,0 +1,243 @@
+﻿/*
+ *   Copyright (c) 2007 John Weaver
+ *   Copyright (c) 2015 Seonho Oh
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+
+#include "munkres_cuda.hpp"
+
+#include <cuda_runtime.h>
+#include <cfloat>
+#include <vector>
+
+namespace munkres_cuda
+{
+	namespace
+	{
+		const unsigned block_size = 256;
+
+		template <typename T> __device__ inline T infinity();
+		template <> __device__ inline float infinity<float>() { return FLT_MAX; }
+		template <> __device__ inline double infinity<double>() { return DBL_MAX; }
+
+		/*
+		One block per problem. The block runs the same shortest augmenting path
+		algorithm as munkres<eT>::SHORTEST_PATH: the threads share the columns of
+		every Dijkstra step (slack update and dual update) and find the closest
+		column with a block-wide reduction. A whole solve is therefore a single
+		launch. A single problem only ever occupies one multiprocessor, though,
+		so the device pays off for batches of many problems, not for one large
+		problem.
+		*/
+		template <typename T>
+		__global__ void shortest_path(const T* costs, unsigned rows, unsigned cols,
+			T* duals, int* links, int* col_of_row)
+		{
+			const unsigned problem = blockIdx.x;
+			const T* cost = costs + (std::size_t)problem * rows * cols;
+
+			// Column cols is the virtual root holding the row being inserted.
+			T* row_dual = duals + (std::size_t)problem * (rows + 2 * (cols + 1));
+			T* col_dual = row_dual + rows;
+			T* min_slack = col_dual + cols + 1;
+
+			int* row_of_col = links + (std::size_t)problem * 3 * (cols + 1);
+			int* col_way = row_of_col + cols + 1;
+			int* col_used = col_way + cols + 1;
+
+			__shared__ T best_value[block_size];
+			__shared__ unsigned best_col[block_size];
+			__shared__ unsigned col0;
+			__shared__ bool searching;
+
+			const T inf = infinity<T>();
+
+			// Row reduction: u(i) = min c(i, j) with v = 0 is a feasible start.
+			for ( unsigned row = threadIdx.x ; row < rows ; row += blockDim.x ) {
+				T lowest = inf;
+				for ( unsigned col = 0 ; col < cols ; col++ )
+					lowest = min(lowest, cost[(std::size_t)col * rows + row]);
+				row_dual[row] = lowest;
+			}
+			__syncthreads();
+
+			// Column reduction, v(j) = min c(i, j) - u(i), for square problems only:
+			// with more columns than rows the free columns have to keep v = 0.
+			for ( unsigned col = threadIdx.x ; col <= cols ; col += blockDim.x ) {
+				T lowest = 0;
+				if ( rows == cols && col < cols ) {
+					lowest = inf;
+					for ( unsigned row = 0 ; row < rows ; row++ )
+						lowest = min(lowest, cost[(std::size_t)col * rows + row] - row_dual[row]);
+				}
+
+				col_dual[col] = lowest;
+				row_of_col[col] = -1;
+			}
+			__syncthreads();
+
+			for ( unsigned row = 0 ; row < rows ; row++ ) {
+				for ( unsigned col = threadIdx.x ; col <= cols ; col += blockDim.x ) {
+					min_slack[col] = inf;
+					col_used[col] = 0;
+				}
+
+				if ( threadIdx.x == 0 ) {
+					row_of_col[cols] = row;
+					col0 = cols;
+				}
+				__syncthreads();
+
+				do {
+					if ( threadIdx.x == 0 )
+						col_used[col0] = 1;
+					__syncthreads();
+
+					const unsigned from = col0;
+					const unsigned row0 = row_of_col[from];
+
+					T delta = inf;
+					unsigned col1 = cols;
+
+					for ( unsigned col = threadIdx.x ; col < cols ; col += blockDim.x ) {
+						if ( !col_used[col] ) {
+							const T cur = cost[(std::size_t)col * rows + row0] - row_dual[row0] - col_dual[col];
+							if ( cur < min_slack[col] ) {
+								min_slack[col] = cur;
+								col_way[col] = from;
+							}
+
+							// On a tie a free column wins, it ends the search right away.
+							if ( min_slack[col] < delta ||
+								(min_slack[col] == delta && row_of_col[col] == -1 && row_of_col[col1] != -1) ) {
+								delta = min_slack[col];
+								col1 = col;
+							}
+						}
+					}
+
+					best_value[threadIdx.x] = delta;
+					best_col[threadIdx.x] = col1;
+					__syncthreads();
+
+					// On a tie a free column wins, then the lower column, as on the CPU.
+					for ( unsigned stride = blockDim.x / 2 ; stride > 0 ; stride /= 2 ) {
+						if ( threadIdx.x < stride ) {
+							const T other = best_value[threadIdx.x + stride];
+							const unsigned other_col = best_col[threadIdx.x + stride];
+							const bool other_free = row_of_col[other_col] == -1,
+								mine_free = row_of_col[best_col[threadIdx.x]] == -1;
+							if ( other < best_value[threadIdx.x] ||
+								(other == best_value[threadIdx.x] && (other_free != mine_free ? other_free : other_col < best_col[threadIdx.x])) ) {
+								best_value[threadIdx.x] = other;
+								best_col[threadIdx.x] = other_col;
+							}
+						}
+						__syncthreads();
+					}
+
+					delta = best_value[0];
+
+					for ( unsigned col = threadIdx.x ; col <= cols ; col += blockDim.x ) {
+						if ( col_used[col] ) {
+							row_dual[row_of_col[col]] += delta;
+							col_dual[col] -= delta;
+						}
+						else
+							min_slack[col] -= delta;
+					}
+					__syncthreads();
+
+					// Every thread has to leave the loop together: thread 0 rewrites
+					// row_of_col in the flip below, so the condition is taken once.
+					if ( threadIdx.x == 0 ) {
+						col0 = best_col[0];
+						searching = row_of_col[col0] != -1;
+					}
+					__syncthreads();
+				} while ( searching );
+
+				// Flip the assignment along the augmenting path back to the root.
+				if ( threadIdx.x == 0 ) {
+					unsigned col = col0;
+					do {
+						const unsigned prev = col_way[col];
+						row_of_col[col] = row_of_col[prev];
+						col = prev;
+					} while ( col != cols );
+				}
+				__syncthreads();
+			}
+
+			int* result = col_of_row + (std::size_t)problem * rows;
+			for ( unsigned col = threadIdx.x ; col < cols ; col += blockDim.x ) {
+				if ( row_of_col[col] != -1 )
+					result[row_of_col[col]] = col;
+			}
+		}
+
+		template <typename T>
+		bool solve_device(const T* costs, std::size_t rows, std::size_t cols, std::size_t count, std::size_t* col_of_row)
+		{
+			int devices = 0;
+			if ( cudaGetDeviceCount(&devices) != cudaSuccess || devices == 0 )
+				return false;
+
+			T* d_costs = NULL;
+			T* d_duals = NULL;
+			int* d_links = NULL;
+			int* d_result = NULL;
+
+			bool ok = cudaMalloc(&d_costs, count * rows * cols * sizeof(T)) == cudaSuccess &&
+				cudaMalloc(&d_duals, count * (rows + 2 * (cols + 1)) * sizeof(T)) == cudaSuccess &&
+				cudaMalloc(&d_links, count * 3 * (cols + 1) * sizeof(int)) == cudaSuccess &&
+				cudaMalloc(&d_result, count * rows * sizeof(int)) == cudaSuccess &&
+				cudaMemcpy(d_costs, costs, count * rows * cols * sizeof(T), cudaMemcpyHostToDevice) == cudaSuccess;
+
+			std::vector<int> result;
+			if ( ok ) {
+				shortest_path<T><<<(unsigned)count, block_size>>>(d_costs, (unsigned)rows, (unsigned)cols, d_duals, d_links, d_result);
+
+				result.resize(count * rows);
+				ok = cudaGetLastError() == cudaSuccess &&
+					cudaMemcpy(&result[0], d_result, count * rows * sizeof(int), cudaMemcpyDeviceToHost) == cudaSuccess;
+			}
+
+			cudaFree(d_costs);
+			cudaFree(d_duals);
+			cudaFree(d_links);
+			cudaFree(d_result);
+
+			if ( !ok )
+				return false;
+
+			for ( std::size_t i = 0 ; i < count * rows ; i++ )
+				col_of_row[i] = result[i];
+
+			return true;
+		}
+	}
+
+	bool solve(const double* costs, std::size_t rows, std::size_t cols, std::size_t count, std::size_t* col_of_row)
+	{
+		return solve_device(costs, rows, cols, count, col_of_row);
+	}
+
+	bool solve(const float* costs, std::size_t rows, std::size_t cols, std::size_t count, std::size_t* col_of_row)
+	{
+		return solve_device(costs, rows, cols, count, col_of_row);
+	}
+};
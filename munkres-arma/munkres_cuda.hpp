@@ -0,0 +1,51 @@
+﻿/*
+ *   Copyright (c) 2007 John Weaver
+ *   Copyright (c) 2015 Seonho Oh
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+
+#if !defined(_MUNKRES_CUDA_HPP_)
+#define _MUNKRES_CUDA_HPP_
+
+#pragma once
+
+#include <cstddef>
+
+/*!
+ * Device side of the shortest augmenting path engine, compiled from
+ * munkres_cuda.cu with nvcc. munkres.hpp uses it when MUNKRES_USE_CUDA is
+ * defined, this header itself does not depend on Armadillo.
+ */
+namespace munkres_cuda
+{
+	/*!
+	 * Solve count problems of rows x cols (rows <= cols) stored one after the
+	 * other in column major order, all without infinities. col_of_row receives
+	 * rows entries per problem. Returns false if no device is available or a
+	 * CUDA call failed, the caller then solves on the CPU.
+	 */
+	bool solve(const double* costs, std::size_t rows, std::size_t cols, std::size_t count, std::size_t* col_of_row);
+	bool solve(const float* costs, std::size_t rows, std::size_t cols, std::size_t count, std::size_t* col_of_row);
+
+	//! Other element types stay on the CPU
+	template <typename eT>
+	inline bool solve(const eT*, std::size_t, std::size_t, std::size_t, std::size_t*)
+	{
+		return false;
+	}
+};
+
+#endif /* !defined(_MUNKRES_CUDA_HPP_) */
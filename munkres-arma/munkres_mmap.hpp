@@ -0,0 +1,156 @@
+﻿/*
+ *   Copyright (c) 2007 John Weaver
+ *   Copyright (c) 2015 Seonho Oh
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+
+#if !defined(_MUNKRES_MMAP_HPP_)
+#define _MUNKRES_MMAP_HPP_
+
+#pragma once
+
+#include <armadillo>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * Read-only view of a rows x cols cost matrix stored in a file as raw eT values,
+ * row after row, mapped into memory instead of loaded. It is a row generator for
+ * munkres<eT>::solve_rows(), which reads one row at a time, so the operating
+ * system pages the file in and out as the solve needs it:
+ *
+ *     munkres_mapped_matrix<double> costs("costs.bin", 60000, 60000);
+ *     munkres<double> solver;
+ *     solver.solve_rows(costs.n_rows, costs.n_cols, costs, assignments);
+ */
+template <typename eT>
+class munkres_mapped_matrix
+{
+public:
+	//! Map path, throws std::runtime_error if it can not or is too short
+	munkres_mapped_matrix(const char* path, arma::uword rows, arma::uword cols)
+		: n_rows(rows), n_cols(cols), data_(NULL)
+	{
+		const unsigned long long bytes = static_cast<unsigned long long>(rows) * cols * sizeof(eT);
+
+#if defined(_WIN32)
+		file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		mapping_ = NULL;
+
+		LARGE_INTEGER size;
+		if ( file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size) ||
+			static_cast<unsigned long long>(size.QuadPart) < bytes ) {
+			close();
+			throw std::runtime_error("munkres_mapped_matrix: can not open the file or it is too short");
+		}
+
+		mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+		if ( mapping_ != NULL )
+			data_ = static_cast<const eT*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+#else
+		file_ = open(path, O_RDONLY);
+		size_ = static_cast<size_t>(bytes);
+
+		struct stat info;
+		if ( file_ < 0 || fstat(file_, &info) != 0 ||
+			static_cast<unsigned long long>(info.st_size) < bytes ) {
+			close();
+			throw std::runtime_error("munkres_mapped_matrix: can not open the file or it is too short");
+		}
+
+		if ( bytes > 0 ) {
+			void* mem = mmap(NULL, size_, PROT_READ, MAP_SHARED, file_, 0);
+			if ( mem != MAP_FAILED )
+				data_ = static_cast<const eT*>(mem);
+		}
+#endif
+
+		if ( data_ == NULL && bytes > 0 ) {
+			close();
+			throw std::runtime_error("munkres_mapped_matrix: can not map the file");
+		}
+	}
+
+	~munkres_mapped_matrix()
+	{
+		close();
+	}
+
+	//! Start of row i in the mapping
+	const eT* row(arma::uword i) const
+	{
+		return data_ + static_cast<size_t>(i) * n_cols;
+	}
+
+	//! Row generator interface of munkres<eT>::solve_rows()
+	void operator()(arma::uword i, eT* out) const
+	{
+		const eT* p = row(i);
+		std::copy(p, p + n_cols, out);
+	}
+
+	const arma::uword	n_rows;
+	const arma::uword	n_cols;
+
+private:
+	// the mapping is owned, so it is not copyable
+	munkres_mapped_matrix(const munkres_mapped_matrix&);
+	munkres_mapped_matrix& operator=(const munkres_mapped_matrix&);
+
+	void close()
+	{
+#if defined(_WIN32)
+		if ( data_ != NULL )
+			UnmapViewOfFile(data_);
+		if ( mapping_ != NULL )
+			CloseHandle(mapping_);
+		if ( file_ != INVALID_HANDLE_VALUE )
+			CloseHandle(file_);
+
+		mapping_ = NULL;
+		file_ = INVALID_HANDLE_VALUE;
+#else
+		if ( data_ != NULL )
+			munmap(const_cast<eT*>(data_), size_);
+		if ( file_ >= 0 )
+			::close(file_);
+
+		file_ = -1;
+#endif
+		data_ = NULL;
+	}
+
+	const eT*	data_;
+
+#if defined(_WIN32)
+	HANDLE		file_;
+	HANDLE		mapping_;
+#else
+	int			file_;
+	size_t		size_;
+#endif
+};
+
+#endif
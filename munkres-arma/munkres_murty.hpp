@@ -0,0 +1,604 @@
+﻿/*
+ *   Copyright (c) 2007 John Weaver
+ *   Copyright (c) 2015 Seonho Oh
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+
+#if !defined(_MUNKRES_MURTY_HPP_)
+#define _MUNKRES_MURTY_HPP_
+
+#pragma once
+
+#include "munkres.hpp"
+#include <queue>
+
+/*!
+ * The k cheapest assignments of a cost matrix, cheapest first (Murty's
+ * algorithm), e.g. for the hypotheses of a multi-hypothesis tracker:
+ *
+ *     munkres_murty<double> murty;
+ *     arma::field<arma::umat> hypotheses;
+ *     arma::vec costs;
+ *     murty.solve(m, 100, hypotheses, costs);
+ *
+ * Each result is in the format of munkres<eT>::solve(), and every two results
+ * differ in at least one (row, column) pair. Costs are summed in acc_type over
+ * a copy of m whose infinities are replaced by its largest finite entry (0 if
+ * there is none), the value the engines solve with. So a result through an
+ * infinite entry has a finite cost here, where the solve() overload that
+ * returns the total sums the entries of m as they are and returns infinity.
+ */
+template <typename eT>
+class munkres_murty
+{
+public:
+	typedef munkres<eT>							solver_type;
+	typedef typename solver_type::config_type	config_type;
+	typedef typename solver_type::acc_type		acc_type;
+	typedef typename solver_type::size_type		size_type;
+
+	munkres_murty()
+	{
+	}
+
+	//! config is used for the first, full solve
+	explicit munkres_murty(const config_type& config)
+		: solver_(config)
+	{
+	}
+
+	/*!
+	 * Write up to the k cheapest assignments of m to assignments and their total
+	 * costs to costs, in ascending order of cost, and return how many there are
+	 * (fewer than k only if m has fewer distinct assignments).
+	 *
+	 * Only the best assignment is a full solve. The others come from Murty's
+	 * partitions: a child of a result keeps that result's first pairs, forbids
+	 * the next one and reassigns the rest. The child starts from its parent's
+	 * assignment and potentials, which are still feasible for it, so it takes a
+	 * single O(n^2) augmentation of the one row whose pair was forbidden. The
+	 * parent's reduced costs also bound each child from below in O(n), and a
+	 * child is solved only when that bound comes out of the priority queue, so
+	 * most children are never solved at all.
+	 */
+	template <typename vec_type>
+	size_type solve(const arma::Mat<eT>& m, size_type k, arma::field<arma::umat>& assignments, vec_type& costs)
+	{
+		found_.clear();
+		nodes_.clear();
+		queue_ = queue_type();
+		known_ = std::priority_queue<acc_type>();
+		wanted_ = k;
+
+		if ( k == 0 ) {
+			assignments.set_size(0);
+			costs.set_size(0);
+			return 0;
+		}
+
+		if ( m.is_empty() ) {
+			assignments.set_size(1);
+			assignments(0).set_size(0, 2);
+			costs.zeros(1);
+			return 1;
+		}
+
+		setup(m);
+
+		queue_.push(entry(nodes_[0].cost, 0, NONE));
+		know(nodes_[0].cost);
+
+		while ( found_.size() < k && !queue_.empty() ) {
+			const entry top = queue_.top();
+			queue_.pop();
+
+			if ( top.child != NONE ) {
+				// a lower bound: solve the child and queue it with its cost
+				if ( top.key <= limit() && solve_child(top.node, top.child, child_) ) {
+					const acc_type cost = child_.cost;
+					nodes_.push_back(child_);
+					queue_.push(entry(cost, nodes_.size() - 1, NONE));
+					know(cost);
+				}
+				continue;
+			}
+
+			found_.push_back(top.node);
+			bound_children(top.node);
+		}
+
+		assignments.set_size(found_.size());
+		costs.set_size(found_.size());
+		for ( size_type n = 0 ; n < found_.size() ; n++ ) {
+			pairs(nodes_[found_[n]], assignments(n));
+			costs[n] = nodes_[found_[n]].cost;
+		}
+
+		return found_.size();
+	}
+
+private:
+	static const size_type NONE = solver_type::NONE;
+
+	/*!
+	 * A solved subproblem: the assignment and potentials of the padded square
+	 * problem (see setup), rows [0, depth) fixed to their columns and the
+	 * pairs in excluded, sorted, forbidden.
+	 */
+	struct node {
+		acc_type	cost;
+		size_type	depth;
+		std::vector<size_type>	col_of_row;
+		std::vector<acc_type>	row_dual;
+		std::vector<acc_type>	col_dual;
+		std::vector<std::pair<size_type, size_type> >	excluded;
+	};
+
+	/*!
+	 * Queue entry: node itself with its cost, or the child-th child of node
+	 * with a lower bound of its cost. Ties go to the earlier entry.
+	 */
+	struct entry {
+		acc_type	key;
+		size_type	node;
+		size_type	child;
+		size_type	sequence;
+
+		entry(acc_type key_, size_type node_, size_type child_)
+			: key(key_), node(node_), child(child_), sequence(0)
+		{
+		}
+
+		bool operator<(const entry& other) const
+		{
+			return key != other.key ? key > other.key : sequence > other.sequence;
+		}
+	};
+
+	struct queue_type : std::priority_queue<entry> {
+		queue_type()
+			: count(0)
+		{
+		}
+
+		void push(entry e)
+		{
+			e.sequence = count++;
+			std::priority_queue<entry>::push(e);
+		}
+
+		size_type count;
+	};
+
+	static acc_type infinity()
+	{
+		return std::numeric_limits<acc_type>::max();
+	}
+
+	/*!
+	 * The k-th lowest cost among the solved nodes, infinity while there are
+	 * fewer. Any k results cost at most that much, so nodes costing more never
+	 * get into the result and are neither solved nor queued.
+	 */
+	acc_type limit() const
+	{
+		return known_.size() < wanted_ ? infinity() : known_.top();
+	}
+
+	void know(acc_type cost)
+	{
+		known_.push(cost);
+		if ( known_.size() > wanted_ )
+			known_.pop();
+	}
+
+	//! Cost of (row, col) in the working problem, the dummy rows cost 0
+	acc_type entry_cost(size_type row, size_type col) const
+	{
+		return row < real_ ? acc_type(cost_[row * columns_ + col]) : acc_type(0);
+	}
+
+	acc_type reduced(const node& n, size_type row, size_type col) const
+	{
+		return entry_cost(row, col) - n.row_dual[row] - n.col_dual[col];
+	}
+
+	/*!
+	 * Solve m and turn the result into the root node. The working problem has
+	 * the shorter dimension of m as its real rows, row major in cost_, and is
+	 * padded to a square with zero cost dummy rows, so that forbidding a pair
+	 * always frees exactly one row and one column. Infinities are replaced as
+	 * in the engines.
+	 */
+	void setup(const arma::Mat<eT>& m)
+	{
+		typename solver_type::state_type state;
+		solver_.solve(m, scratch_, state);
+
+		transposed_ = m.n_rows > m.n_cols;
+		real_ = std::min(m.n_rows, m.n_cols);
+		columns_ = std::max(m.n_rows, m.n_cols);
+
+		cost_.resize(real_ * columns_);
+		bool found = false;
+		eT fill = eT(0);
+		for ( size_type row = 0 ; row < real_ ; row++ ) {
+			for ( size_type col = 0 ; col < columns_ ; col++ ) {
+				const eT v = transposed_ ? m.at(col, row) : m.at(row, col);
+				cost_[row * columns_ + col] = v;
+				if ( arma::is_finite(v) && (!found || v > fill) ) {
+					fill = v;
+					found = true;
+				}
+			}
+		}
+
+		if ( std::numeric_limits<eT>::has_infinity ) {
+			for ( size_type k = 0 ; k < cost_.size() ; k++ ) {
+				if ( !arma::is_finite(cost_[k]) )
+					cost_[k] = fill;
+			}
+		}
+
+		nodes_.push_back(node());
+		node& root = nodes_.back();
+		root.depth = 0;
+		root.col_of_row.assign(columns_, NONE);
+		root.row_dual.assign(columns_, 0);
+		root.col_dual.assign(columns_, 0);
+
+		const arma::Col<acc_type>& row_dual = transposed_ ? state.col_dual : state.row_dual;
+		const arma::Col<acc_type>& col_dual = transposed_ ? state.row_dual : state.col_dual;
+
+		for ( size_type row = 0 ; row < real_ ; row++ )
+			root.row_dual[row] = row_dual[row];
+
+		acc_type highest = col_dual[0];
+		for ( size_type col = 0 ; col < columns_ ; col++ ) {
+			root.col_dual[col] = col_dual[col];
+			highest = std::max(highest, col_dual[col]);
+		}
+
+		if ( transposed_ ) {
+			for ( size_type col = 0 ; col < columns_ ; col++ ) {
+				if ( state.col_of_row[col] != NONE )
+					root.col_of_row[state.col_of_row[col]] = col;
+			}
+		}
+		else {
+			for ( size_type row = 0 ; row < real_ ; row++ )
+				root.col_of_row[row] = state.col_of_row[row];
+		}
+
+		// The dummy rows start feasible and are matched to the free columns. With
+		// the engine's potentials every one of them finds a free column at once.
+		fixed_col_.assign(columns_, 0);
+		for ( size_type row = real_ ; row < columns_ ; row++ ) {
+			root.row_dual[row] = -highest;
+			augment(root, row, infinity());
+		}
+
+		root.cost = total(root);
+	}
+
+	acc_type total(const node& n) const
+	{
+		acc_type sum = 0;
+		for ( size_type row = 0 ; row < real_ ; row++ )
+			sum += entry_cost(row, n.col_of_row[row]);
+
+		return sum;
+	}
+
+	/*!
+	 * Queue a lower bound for every child of node index. Child i keeps the
+	 * parent's pairs of rows [0, depth + i) and forbids the pair of row
+	 * r = depth + i. The parent's potentials stay feasible and its pairs
+	 * tight, so the child's cost exceeds the parent's by the sum of the reduced
+	 * costs of its pairs. Two of them are another column for r and another row
+	 * for the column c of r, so that sum is at least the cheapest of each.
+	 */
+	void bound_children(size_type index)
+	{
+		const node& parent = nodes_[index];
+
+		fixed_col_.assign(columns_, 0);
+		banned_.assign(columns_, 0);
+		for ( size_type k = 0 ; k < parent.depth ; k++ )
+			fixed_col_[parent.col_of_row[k]] = 1;
+
+		// The other rows of the child for row k are (k, real_) and the dummies, so the
+		// cheapest of them per column are suffix minima, folded in row by row.
+		acc_type dummy = infinity();
+		for ( size_type row = real_ ; row < columns_ ; row++ )
+			dummy = std::min(dummy, -parent.row_dual[row]);
+
+		column_min_.resize(columns_);
+		for ( size_type col = 0 ; col < columns_ ; col++ )
+			column_min_[col] = dummy == infinity() ? dummy : dummy - parent.col_dual[col];
+
+		by_col_.resize(real_);
+		for ( size_type k = real_ ; k-- > parent.depth ; ) {
+			const size_type row = k,
+				col = parent.col_of_row[row];
+
+			by_col_[k] = excluded_col(parent, col) ? other_row(parent, k) : column_min_[col];
+
+			const eT* costs = &cost_[row * columns_];
+			const acc_type base = -parent.row_dual[row];
+			for ( size_type j = 0 ; j < columns_ ; j++ )
+				column_min_[j] = std::min(column_min_[j], base + acc_type(costs[j]) - parent.col_dual[j]);
+		}
+
+		for ( size_type k = parent.depth ; k < real_ ; k++ ) {
+			const size_type row = k,
+				col = parent.col_of_row[row];
+
+			// cheapest other column of row
+			mark(parent.excluded, row, 1);
+			const eT* costs = &cost_[row * columns_];
+			const acc_type base = -parent.row_dual[row];
+			acc_type by_row = infinity();
+			for ( size_type j = 0 ; j < columns_ ; j++ ) {
+				if ( !fixed_col_[j] && !banned_[j] && j != col )
+					by_row = std::min(by_row, base + acc_type(costs[j]) - parent.col_dual[j]);
+			}
+			mark(parent.excluded, row, 0);
+
+			const acc_type by_col = by_col_[k];
+			if ( by_row != infinity() && by_col != infinity() && parent.cost + by_row + by_col <= limit() )
+				queue_.push(entry(parent.cost + by_row + by_col, index, k - parent.depth));
+
+			fixed_col_[col] = 1;
+		}
+	}
+
+	//! Whether a pair of col is forbidden in n
+	static bool excluded_col(const node& n, size_type col)
+	{
+		for ( size_type e = 0 ; e < n.excluded.size() ; e++ ) {
+			if ( n.excluded[e].second == col )
+				return true;
+		}
+
+		return false;
+	}
+
+	//! Cheapest allowed row for the column of row k in the child for row k, see bound_children
+	acc_type other_row(const node& n, size_type k)
+	{
+		const size_type col = n.col_of_row[k];
+
+		acc_type best = infinity();
+		for ( size_type row = real_ ; row < columns_ ; row++ )
+			best = std::min(best, reduced(n, row, col));
+
+		for ( size_type row = k + 1 ; row < real_ ; row++ ) {
+			if ( !std::binary_search(n.excluded.begin(), n.excluded.end(), std::make_pair(row, col)) )
+				best = std::min(best, reduced(n, row, col));
+		}
+
+		return best;
+	}
+
+	/*!
+	 * Solve the child-th child of node index into result, see bound_children.
+	 * result is reused, most children end up over the limit and are dropped.
+	 */
+	bool solve_child(size_type index, size_type child, node& result)
+	{
+		const node& parent = nodes_[index];
+
+		result.depth = parent.depth + child;
+		result.col_of_row = parent.col_of_row;
+		result.row_dual = parent.row_dual;
+		result.col_dual = parent.col_dual;
+
+		const size_type row = result.depth,
+			col = parent.col_of_row[row];
+
+		result.excluded = parent.excluded;
+		result.excluded.insert(std::upper_bound(result.excluded.begin(), result.excluded.end(),
+			std::make_pair(row, col)), std::make_pair(row, col));
+
+		fixed_col_.assign(columns_, 0);
+		for ( size_type k = 0 ; k < result.depth ; k++ )
+			fixed_col_[result.col_of_row[k]] = 1;
+
+		// the child's cost is the parent's plus the length of its augmenting path
+		const acc_type bound = limit();
+
+		result.col_of_row[row] = NONE;
+		if ( !augment(result, row, bound == infinity() ? bound : bound - parent.cost) )
+			return false;
+
+		result.cost = total(result);
+		return true;
+	}
+
+	/*!
+	 * Shortest augmenting path from the free row root to the free column, with
+	 * Dijkstra on the reduced costs, avoiding the fixed columns (fixed_col_) and
+	 * the forbidden pairs of n. The potentials are updated once at the end, from
+	 * the distances of the columns taken on the way. Returns false if no path
+	 * exists, or none of length at most budget (which may be infinity()).
+	 */
+	bool augment(node& n, size_type root, acc_type budget)
+	{
+		row_of_col_.assign(columns_, NONE);
+		for ( size_type row = 0 ; row < columns_ ; row++ ) {
+			if ( n.col_of_row[row] != NONE )
+				row_of_col_[n.col_of_row[row]] = row;
+		}
+
+		// 0 open, 1 taken, 2 fixed
+		col_used_.resize(columns_);
+		for ( size_type col = 0 ; col < columns_ ; col++ )
+			col_used_[col] = fixed_col_[col] ? 2 : 0;
+
+		distance_.assign(columns_, infinity());
+		row_way_.assign(columns_, NONE);
+		banned_ = col_used_;
+		zero_row_.resize(columns_, eT(0));
+		taken_.clear();
+
+		size_type row0 = root,
+			col1 = NONE;
+		acc_type length = 0;
+
+		for ( ;; ) {
+			const eT* costs = row0 < real_ ? &cost_[row0 * columns_] : &zero_row_[0];
+			const acc_type base = length - n.row_dual[row0];
+
+			// taken, fixed and forbidden columns are flagged in banned_
+			mark(n.excluded, row0, 1);
+			acc_type delta = infinity();
+			col1 = NONE;
+			for ( size_type col = 0 ; col < columns_ ; col++ ) {
+				const acc_type d = base + acc_type(costs[col]) - n.col_dual[col];
+				const bool better = !banned_[col] && d < distance_[col];
+
+				distance_[col] = better ? d : distance_[col];
+				row_way_[col] = better ? row0 : row_way_[col];
+
+				if ( !col_used_[col] && distance_[col] < delta ) {
+					delta = distance_[col];
+					col1 = col;
+				}
+			}
+			restore(n.excluded, row0);
+
+			// the columns come in order of their distance from the root
+			if ( col1 == NONE || (budget != infinity() && delta > budget) )
+				return false;
+
+			length = delta;
+			col_used_[col1] = 1;
+			banned_[col1] = 1;
+			if ( row_of_col_[col1] == NONE )
+				break;
+
+			taken_.push_back(col1);
+			row0 = row_of_col_[col1];
+		}
+
+		// Potentials: keeps the path tight and every reduced cost non-negative
+		n.row_dual[root] += length;
+		for ( size_type k = 0 ; k < taken_.size() ; k++ ) {
+			const size_type col = taken_[k];
+			const acc_type shift = length - distance_[col];
+
+			n.row_dual[row_of_col_[col]] += shift;
+			n.col_dual[col] -= shift;
+		}
+
+		// flip the path back to the root
+		for ( size_type col = col1 ; ; ) {
+			const size_type row = row_way_[col],
+				next = n.col_of_row[row];
+
+			n.col_of_row[row] = col;
+			if ( row == root )
+				break;
+
+			col = next;
+		}
+
+		return true;
+	}
+
+	//! Set banned_ to value for the forbidden columns of row
+	void mark(const std::vector<std::pair<size_type, size_type> >& excluded, size_type row, unsigned char value)
+	{
+		typename std::vector<std::pair<size_type, size_type> >::const_iterator it =
+			std::lower_bound(excluded.begin(), excluded.end(), std::make_pair(row, size_type(0)));
+
+		for ( ; it != excluded.end() && it->first == row ; ++it )
+			banned_[it->second] = value;
+	}
+
+	//! Undo mark(excluded, row, 1) in augment, the columns keep their col_used_ flag
+	void restore(const std::vector<std::pair<size_type, size_type> >& excluded, size_type row)
+	{
+		typename std::vector<std::pair<size_type, size_type> >::const_iterator it =
+			std::lower_bound(excluded.begin(), excluded.end(), std::make_pair(row, size_type(0)));
+
+		for ( ; it != excluded.end() && it->first == row ; ++it )
+			banned_[it->second] = col_used_[it->second];
+	}
+
+	//! The real pairs of n as row-sorted (row, column) pairs of the input
+	void pairs(const node& n, arma::umat& assignments)
+	{
+		assignments.set_size(real_, 2);
+
+		if ( transposed_ ) {
+			// input rows are the working columns, visited in order
+			row_of_col_.assign(columns_, NONE);
+			for ( size_type row = 0 ; row < real_ ; row++ )
+				row_of_col_[n.col_of_row[row]] = row;
+
+			for ( size_type col = 0, k = 0 ; col < columns_ ; col++ ) {
+				if ( row_of_col_[col] != NONE ) {
+					assignments.at(k, 0) = col;
+					assignments.at(k, 1) = row_of_col_[col];
+					k++;
+				}
+			}
+		}
+		else {
+			for ( size_type row = 0 ; row < real_ ; row++ ) {
+				assignments.at(row, 0) = row;
+				assignments.at(row, 1) = n.col_of_row[row];
+			}
+		}
+	}
+
+	solver_type			solver_;
+	arma::umat			scratch_;
+
+	// working problem: real_ rows of columns_ entries, padded to columns_ rows
+	std::vector<eT>		cost_;
+	size_type			real_;
+	size_type			columns_;
+	bool				transposed_;
+
+	std::vector<node>	nodes_;
+	node				child_;
+	std::vector<size_type>	found_;
+	queue_type			queue_;
+
+	// the wanted_ lowest costs solved so far, highest on top
+	std::priority_queue<acc_type>	known_;
+	size_type			wanted_;
+
+	// scratch of bound_children and augment
+	std::vector<unsigned char>	fixed_col_;
+	std::vector<acc_type>	column_min_;
+	std::vector<acc_type>	by_col_;
+	std::vector<unsigned char>	banned_;
+	std::vector<eT>		zero_row_;
+	std::vector<size_type>	row_of_col_;
+	std::vector<size_type>	row_way_;
+	std::vector<unsigned char>	col_used_;
+	std::vector<acc_type>	distance_;
+	std::vector<size_type>	taken_;
+};
+
+template <typename eT>
+const typename munkres_murty<eT>::size_type munkres_murty<eT>::NONE;
+
+#endif
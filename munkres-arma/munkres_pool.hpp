@@ -0,0 +1,133 @@
+﻿/*
+ *   Copyright (c) 2007 John Weaver
+ *   Copyright (c) 2015 Seonho Oh
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+
+#if !defined(_MUNKRES_POOL_HPP_)
+#define _MUNKRES_POOL_HPP_
+
+#pragma once
+
+#include "munkres.hpp"
+
+/*!
+ * A shared, immutable solver configuration for many worker threads. The config
+ * and the engine are fixed at construction, and solve() is const: every thread
+ * that calls it solves on its own munkres<eT> workspace, created on the first
+ * call from that thread and kept until the thread exits. Concurrent solves take
+ * no locks, and once a thread has seen its largest problem they allocate no
+ * memory either:
+ *
+ *     munkres<double>::config_type config;
+ *     config.tolerance = 1e-9;
+ *     const munkres_pool<double> pool(config, munkres<double>::SHORTEST_PATH);
+ *
+ *     // in any number of threads
+ *     arma::umat assignments = pool.solve(costs);
+ *
+ * The workspaces are per thread and per element type, so all pools of one eT
+ * share them. A cost functor passed to solve() must therefore not solve on a
+ * pool of the same eT itself.
+ */
+template <typename eT>
+class munkres_pool
+{
+public:
+	typedef munkres<eT>							solver_type;
+	typedef typename solver_type::config_type	config_type;
+	typedef typename solver_type::method_type	method_type;
+	typedef typename solver_type::acc_type		acc_type;
+	typedef typename solver_type::size_type		size_type;
+
+	explicit munkres_pool(const config_type& config = config_type(), method_type method = solver_type::STEPS)
+		: config_(config), method_(method)
+	{
+	}
+
+	const config_type& config() const
+	{
+		return config_;
+	}
+
+	method_type method() const
+	{
+		return method_;
+	}
+
+	void solve(const arma::Mat<eT>& m, arma::umat& assignments) const
+	{
+		acquire().solve(m, assignments, method_);
+	}
+
+	arma::umat solve(const arma::Mat<eT>& m) const
+	{
+		arma::umat assignments;
+		solve(m, assignments);
+		return assignments;
+	}
+
+	//! Column of every row and the total cost, see munkres<eT>::solve
+	acc_type solve(const arma::Mat<eT>& m, arma::uvec& assignment) const
+	{
+		return acquire().solve(m, assignment, method_);
+	}
+
+	//! Functor costs, always with the shortest path engine, see munkres<eT>::solve
+	template <typename function_type>
+	void solve(size_type rows, size_type cols, const function_type& cost, arma::umat& assignments) const
+	{
+		acquire().solve(rows, cols, cost, assignments);
+	}
+
+	//! Let the workspace of the calling thread go, e.g. after an unusually large problem
+	static void release()
+	{
+		workspace() = solver_type();
+	}
+
+private:
+	//! Workspace of the calling thread, set up with this pool's config
+	solver_type& acquire() const
+	{
+		solver_type& solver = workspace();
+		solver.configure(config_);
+		return solver;
+	}
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+	// Before VS2015 thread local storage only holds plain data, so each thread's
+	// workspace stays allocated after the thread exits.
+	static solver_type& workspace()
+	{
+		static __declspec(thread) solver_type* solver = NULL;
+		if ( solver == NULL )
+			solver = new solver_type;
+		return *solver;
+	}
+#else
+	static solver_type& workspace()
+	{
+		static thread_local solver_type solver;
+		return solver;
+	}
+#endif
+
+	const config_type	config_;
+	const method_type	method_;
+};
+
+#endif
@@ -0,0 +1,952 @@
+﻿/*
+ *   Copyright (c) 2007 John Weaver
+ *   Copyright (c) 2015 Seonho Oh
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+
+#include <cstddef>
+
+// Armadillo takes the memory of its matrices from posix_memalign or
+// _aligned_malloc, not operator new. Route it through the counter as well.
+void* bench_arma_alloc(std::size_t size);
+void bench_arma_free(void* p);
+
+#define ARMA_ALIEN_MEM_ALLOC_FUNCTION bench_arma_alloc
+#define ARMA_ALIEN_MEM_FREE_FUNCTION bench_arma_free
+
+#include "munkres.hpp"
+#include "munkres_mmap.hpp"
+#include "munkres_murty.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define BENCH_NOEXCEPT throw()
+#else
+#define BENCH_NOEXCEPT noexcept
+#endif
+
+// Out of line, or GCC inlines operator delete and warns about free() on memory from operator new.
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+// Heap allocations made while counting is set, for --allocations
+static bool counting = false;
+static unsigned long long allocations = 0;
+
+void* operator new(std::size_t size)
+{
+	if ( counting )
+		allocations++;
+
+	void* p = std::malloc(size > 0 ? size : 1);
+	if ( p == NULL )
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+BENCH_NOINLINE void operator delete(void* p) BENCH_NOEXCEPT
+{
+	std::free(p);
+}
+
+BENCH_NOINLINE void operator delete[](void* p) BENCH_NOEXCEPT
+{
+	std::free(p);
+}
+
+void* bench_arma_alloc(std::size_t size)
+{
+	if ( counting )
+		allocations++;
+
+	return std::malloc(size > 0 ? size : 1);
+}
+
+void bench_arma_free(void* p)
+{
+	std::free(p);
+}
+
+/*!
+ * Seeded generator (splitmix64), so that problems are bit for bit the same on
+ * every platform and standard library for a given seed.
+ */
+class generator
+{
+public:
+	explicit generator(unsigned long long seed)
+		: state_(seed)
+	{
+	}
+
+	unsigned long long next()
+	{
+		unsigned long long z = (state_ += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	//! uniform in [0, 1)
+	double uniform()
+	{
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	//! uniform integer in [lo, hi]
+	int integer(int lo, int hi)
+	{
+		return lo + static_cast<int>(next() % static_cast<unsigned long long>(hi - lo + 1));
+	}
+
+private:
+	unsigned long long state_;
+};
+
+enum distribution_type {
+	UNIFORM_INT,	//!< integers in [1, 1000]
+	UNIFORM_REAL,	//!< reals in [0, 1)
+	MANY_TIES,		//!< integers in [0, 3]
+	WITH_INF,		//!< integers in [1, 1000] with 10% infinite entries
+	CONSTANT,		//!< every entry 1, so every assignment is optimal
+	INF_LINES,		//!< integers in [1, 1000] with 10% of the rows and columns all infinite
+	SPARSE			//!< 5% of the entries stored in an arma::SpMat, the rest infeasible
+};
+
+static const char* const distribution_names[] = { "int", "real", "ties", "inf", "const", "inflines", "sparse" };
+
+struct engine_type {
+	const char*						name;
+	munkres<double>::method_type	method;
+};
+
+static const engine_type engines[] = {
+	{ "steps", munkres<double>::STEPS },
+	{ "slack", munkres<double>::STEPS_SLACK },
+	{ "sap", munkres<double>::SHORTEST_PATH },
+	{ "auction", munkres<double>::AUCTION }
+};
+
+enum shape_type { SQUARE, TALL, WIDE, ROW, COLUMN };
+
+static const char* const shape_names[] = { "square", "tall", "wide", "row", "column" };
+
+static const arma::uword sizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 10000 };
+
+//! Dense problem of the given distribution, the same for the same generator state
+arma::mat dense_problem(generator& gen, arma::uword rows, arma::uword cols, distribution_type dist)
+{
+	arma::mat cost(rows, cols);
+	double* mem = cost.memptr();
+
+	for ( arma::uword i = 0 ; i < cost.n_elem ; i++ ) {
+		switch (dist) {
+		case UNIFORM_REAL:
+			mem[i] = gen.uniform();
+			break;
+		case MANY_TIES:
+			mem[i] = gen.integer(0, 3);
+			break;
+		case WITH_INF:
+			mem[i] = gen.uniform() < 0.1 ? std::numeric_limits<double>::infinity() : gen.integer(1, 1000);
+			break;
+		case CONSTANT:
+			mem[i] = 1;
+			break;
+		default:
+			mem[i] = gen.integer(1, 1000);
+			break;
+		}
+	}
+
+	if (dist == INF_LINES) {
+		for ( arma::uword row = 0 ; row < rows ; row++ ) {
+			if ( gen.uniform() < 0.1 )
+				cost.row(row).fill(std::numeric_limits<double>::infinity());
+		}
+
+		for ( arma::uword col = 0 ; col < cols ; col++ ) {
+			if ( gen.uniform() < 0.1 )
+				cost.col(col).fill(std::numeric_limits<double>::infinity());
+		}
+	}
+
+	// never all infinite
+	if (dist == WITH_INF || dist == INF_LINES)
+		mem[0] = 1;
+
+	return cost;
+}
+
+//! Sparse problem: every column keeps one entry on a cycling diagonal plus 5% random ones
+arma::sp_mat sparse_problem(generator& gen, arma::uword rows, arma::uword cols)
+{
+	const arma::uword extra = static_cast<arma::uword>(0.05 * rows) + 1;
+
+	std::vector<arma::uword> row_index, col_index;
+	std::vector<double> value;
+
+	for ( arma::uword col = 0 ; col < cols ; col++ ) {
+		row_index.push_back(col % rows);
+		col_index.push_back(col);
+		value.push_back(gen.integer(1, 1000));
+
+		for ( arma::uword k = 0 ; k < extra ; k++ ) {
+			const arma::uword row = gen.next() % rows;
+			if ( row == col % rows )
+				continue;
+
+			row_index.push_back(row);
+			col_index.push_back(col);
+			value.push_back(gen.integer(1, 1000));
+		}
+	}
+
+	arma::umat locations(2, value.size());
+	arma::vec values(value.size());
+	for ( arma::uword n = 0 ; n < value.size() ; n++ ) {
+		locations.at(0, n) = row_index[n];
+		locations.at(1, n) = col_index[n];
+		values[n] = value[n];
+	}
+
+	// duplicate locations are summed up, which is fine here
+	return arma::sp_mat(true, locations, values, rows, cols);
+}
+
+//! Whether assignments has the format of munkres<eT>::solve() for a rows x cols problem
+bool valid(const arma::umat& assignments, arma::uword rows, arma::uword cols)
+{
+	if ( assignments.n_rows != std::min(rows, cols) || (assignments.n_rows > 0 && assignments.n_cols != 2) )
+		return false;
+
+	std::vector<bool> used(cols, false);
+	for ( arma::uword r = 0 ; r < assignments.n_rows ; r++ ) {
+		const arma::uword row = assignments.at(r, 0),
+			col = assignments.at(r, 1);
+
+		if ( row >= rows || col >= cols || used[col] || (r > 0 && row <= assignments.at(r - 1, 0)) )
+			return false;
+
+		used[col] = true;
+	}
+
+	return true;
+}
+
+//! Total cost with the infinities at the largest finite entry, as the engines see them
+double total_cost(const arma::mat& cost, const arma::umat& assignments)
+{
+	double fill = 0;
+	bool found = false;
+	for ( arma::uword i = 0 ; i < cost.n_elem ; i++ ) {
+		if ( arma::is_finite(cost[i]) && (!found || cost[i] > fill) ) {
+			fill = cost[i];
+			found = true;
+		}
+	}
+
+	double total = 0;
+	for ( arma::uword r = 0 ; r < assignments.n_rows ; r++ ) {
+		const double value = cost(assignments.at(r, 0), assignments.at(r, 1));
+		total += arma::is_finite(value) ? value : fill;
+	}
+
+	return total;
+}
+
+//! Total cost of a sparse assignment, NaN if it uses a missing entry
+double total_cost(const arma::sp_mat& cost, const arma::umat& assignments)
+{
+	double total = 0;
+	for ( arma::uword r = 0 ; r < assignments.n_rows ; r++ ) {
+		const double value = cost(assignments.at(r, 0), assignments.at(r, 1));
+		if ( value == 0 )
+			return std::numeric_limits<double>::quiet_NaN();
+
+		total += value;
+	}
+
+	return total;
+}
+
+/*!
+ * Reference cost: the step engine on the dense problem. For sparse problems
+ * the missing entries cost more than any assignment of stored ones, which
+ * the generator guarantees to exist.
+ */
+double reference_cost(const arma::mat& cost, const arma::sp_mat& sparse, bool is_sparse)
+{
+	munkres<double> solver;
+
+	if ( !is_sparse )
+		return total_cost(cost, solver.solve(cost));
+
+	double high = 0;
+	for ( arma::uword k = 0 ; k < sparse.n_nonzero ; k++ )
+		high = std::max(high, sparse.values[k]);
+
+	arma::mat dense(sparse.n_rows, sparse.n_cols);
+	dense.fill((high + 1) * (std::min(sparse.n_rows, sparse.n_cols) + 1));
+	for ( arma::uword col = 0 ; col < sparse.n_cols ; col++ ) {
+		for ( arma::uword k = sparse.col_ptrs[col] ; k < sparse.col_ptrs[col + 1] ; k++ )
+			dense.at(sparse.row_indices[k], col) = sparse.values[k];
+	}
+
+	return total_cost(sparse, solver.solve(dense));
+}
+
+/*!
+ * The fixed-size solver on narrow integers drawn from their whole range, where
+ * potentials kept in eT would overflow. Returns the number of wrong costs.
+ */
+template <typename eT, arma::uword N>
+int check_fixed(generator& gen, int count)
+{
+	const double lowest = std::numeric_limits<eT>::min(),
+		span = double(std::numeric_limits<eT>::max()) - lowest + 1;
+
+	munkres<eT, N> solver;
+	int wrong = 0;
+
+	for ( int k = 0 ; k < count ; k++ ) {
+		typename munkres<eT, N>::matrix_type cost;
+		arma::mat reference(N, N);
+		for ( arma::uword i = 0 ; i < N * N ; i++ ) {
+			cost[i] = eT(lowest + std::floor(span * gen.uniform()));
+			reference[i] = cost[i];
+		}
+
+		if ( total_cost(reference, solver.solve(cost)) != reference_cost(reference, arma::sp_mat(), false) )
+			wrong++;
+	}
+
+	return wrong;
+}
+
+/*!
+ * The auction on 64-bit integers far from zero, 2^60 plus [0, 16), which a
+ * double holds only to the nearest 256. Returns the number of totals that
+ * differ from the step engine's.
+ */
+int check_auction_s64(generator& gen, int count)
+{
+	munkres<arma::s64> solver;
+	arma::uvec assignment;
+	int wrong = 0;
+
+	for ( int k = 0 ; k < count ; k++ ) {
+		const arma::uword n = gen.integer(2, 5);
+
+		arma::Mat<arma::s64> cost(n, n);
+		for ( arma::uword i = 0 ; i < cost.n_elem ; i++ )
+			cost[i] = (arma::s64(1) << 60) + gen.integer(0, 15);
+
+		if ( solver.solve(cost, assignment, munkres<arma::s64>::AUCTION) !=
+			solver.solve(cost, assignment, munkres<arma::s64>::STEPS) )
+			wrong++;
+	}
+
+	return wrong;
+}
+
+//! Equal up to rounding; the auction is exact only to about 1e-9 of the cost range per entry
+bool matches(double cost, double reference)
+{
+	return std::abs(cost - reference) <= 1e-6 * std::max(1.0, std::abs(reference));
+}
+
+//! Cost functor over a dense matrix, for the functor form of solve()
+struct matrix_cost {
+	explicit matrix_cost(const arma::mat& m) : cost(m) {}
+
+	double operator()(arma::uword i, arma::uword j) const
+	{
+		return cost.at(i, j);
+	}
+
+	const arma::mat&	cost;
+};
+
+//! Row generator over a dense matrix, for solve_rows()
+struct matrix_rows {
+	explicit matrix_rows(const arma::mat& m) : cost(m) {}
+
+	void operator()(arma::uword i, double* out) const
+	{
+		for ( arma::uword j = 0 ; j < cost.n_cols ; j++ )
+			out[j] = cost.at(i, j);
+	}
+
+	const arma::mat&	cost;
+};
+
+enum entry_type { BLOCKS, BATCH, FIXED, FUNCTOR, ROWS, MAPPED, MURTY };
+
+static const char* const entry_names[] = { "blocks", "batch", "fixed", "functor", "rows", "mmap", "murty" };
+
+//! Problem and failure counts of one entry point
+struct tally_type {
+	int		problems;
+	int		wrong;
+
+	void add(const arma::mat& cost, const arma::umat& assignments, double reference)
+	{
+		problems++;
+		if ( !valid(assignments, cost.n_rows, cost.n_cols) || !matches(total_cost(cost, assignments), reference) )
+			wrong++;
+	}
+};
+
+/*!
+ * The entry points the timed cases do not reach, on small problems of every
+ * dense distribution and shape: solve_blocks() and the batch solves with every
+ * engine, the fixed-size solver, the functor form, solve_rows() on a generator
+ * and on a memory-mapped file, and munkres_murty, whose first assignment has to
+ * be the optimum and whose costs have to ascend. Prints a line per entry point
+ * and returns the number of wrong results.
+ */
+int check_entry_points(unsigned long long seed, const char* path)
+{
+	const int entry_count = sizeof(entry_names) / sizeof(entry_names[0]),
+		shape_count = sizeof(shape_names) / sizeof(shape_names[0]),
+		engine_count = sizeof(engines) / sizeof(engines[0]);
+	const arma::uword check_sizes[] = { 1, 8, 24 };
+
+	tally_type tallies[entry_count];
+	for ( int k = 0 ; k < entry_count ; k++ ) {
+		tallies[k].problems = 0;
+		tallies[k].wrong = 0;
+	}
+
+	munkres<double> solver;
+	munkres<double, 8> fixed;
+	munkres_murty<double> murty;
+
+	for ( int d = 0 ; d < SPARSE ; d++ ) {
+		for ( int s = 0 ; s < shape_count ; s++ ) {
+			for ( size_t k = 0 ; k < sizeof(check_sizes) / sizeof(check_sizes[0]) ; k++ ) {
+				const arma::uword n = check_sizes[k],
+					rows = s == TALL ? 2 * n : (s == ROW ? 1 : n),
+					cols = s == WIDE ? 2 * n : (s == COLUMN ? 1 : n);
+
+				generator gen(seed ^ (0x27D4EB2F165667C5ULL * (n * 64 + s * 8 + d)));
+				const arma::mat cost = dense_problem(gen, rows, cols, distribution_type(d));
+				const double reference = reference_cost(cost, arma::sp_mat(), false);
+
+				arma::field<arma::mat> batch(2);
+				batch(0) = cost;
+				batch(1) = dense_problem(gen, rows, cols, distribution_type(d));
+				const double second = reference_cost(batch(1), arma::sp_mat(), false);
+
+				arma::cube slices(rows, cols, 2);
+				slices.slice(0) = batch(0);
+				slices.slice(1) = batch(1);
+
+				for ( int e = 0 ; e < engine_count ; e++ ) {
+					tallies[BLOCKS].add(cost, solver.solve_blocks(cost, engines[e].method), reference);
+
+					const arma::field<arma::umat> from_field = solver.solve(batch, engines[e].method, 2),
+						from_cube = solver.solve(slices, engines[e].method, 2);
+					tallies[BATCH].add(batch(0), from_field(0), reference);
+					tallies[BATCH].add(batch(1), from_field(1), second);
+					tallies[BATCH].add(batch(0), from_cube(0), reference);
+					tallies[BATCH].add(batch(1), from_cube(1), second);
+				}
+
+				if ( rows == 8 && cols == 8 )
+					tallies[FIXED].add(cost, fixed.solve(cost), reference);
+
+				arma::umat assignments;
+				solver.solve(rows, cols, matrix_cost(cost), assignments);
+				tallies[FUNCTOR].add(cost, assignments, reference);
+
+				solver.solve_rows(rows, cols, matrix_rows(cost), assignments);
+				tallies[ROWS].add(cost, assignments, reference);
+
+				// the file holds the rows one after the other, i.e. the transpose column major
+				const arma::mat row_major = cost.t();
+				FILE* file = std::fopen(path, "wb");
+				bool written = file != NULL &&
+					std::fwrite(row_major.memptr(), sizeof(double), row_major.n_elem, file) == row_major.n_elem;
+
+				if ( file != NULL )
+					written = std::fclose(file) == 0 && written;
+
+				if ( written ) {
+					const munkres_mapped_matrix<double> mapped(path, rows, cols);
+					solver.solve_rows(mapped.n_rows, mapped.n_cols, mapped, assignments);
+					tallies[MAPPED].add(cost, assignments, reference);
+				}
+				else {
+					tallies[MAPPED].problems++;
+					tallies[MAPPED].wrong++;
+				}
+
+				std::remove(path);
+
+				arma::field<arma::umat> best;
+				arma::vec costs;
+				const arma::uword found = murty.solve(cost, 3, best, costs);
+				tallies[MURTY].problems++;
+				bool ok = found > 0 && matches(costs[0], reference);
+				for ( arma::uword i = 0 ; ok && i < found ; i++ ) {
+					ok = valid(best(i), rows, cols) && matches(total_cost(cost, best(i)), costs[i]) &&
+						(i == 0 || costs[i - 1] <= costs[i]);
+				}
+
+				if ( !ok )
+					tallies[MURTY].wrong++;
+			}
+		}
+	}
+
+	int wrong = 0;
+	for ( int k = 0 ; k < entry_count ; k++ ) {
+		std::printf("# %-8s %4d problems, %d wrong\n", entry_names[k], tallies[k].problems, tallies[k].wrong);
+		wrong += tallies[k].wrong;
+	}
+
+	return wrong;
+}
+
+//! The q-quantile of sorted samples (nearest rank)
+double percentile(const std::vector<double>& sorted, double q)
+{
+	const size_t rank = static_cast<size_t>(std::ceil(q * sorted.size()));
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+//! One line of the report
+struct result_type {
+	std::string		engine;
+	std::string		shape;
+	std::string		dist;
+	arma::uword		rows;
+	arma::uword		cols;
+	arma::uword		solves;
+	double			mean_ns;
+	double			p50_ns;
+	double			p90_ns;
+	double			p99_ns;
+	double			cost;
+	double			reference;	//!< NaN without --check
+	bool			ok;			//!< valid format and, with --check, the reference cost
+
+	std::string key() const
+	{
+		char buffer[64];
+		std::sprintf(buffer, ",%llu,%llu", (unsigned long long)rows, (unsigned long long)cols);
+		return engine + "," + shape + "," + dist + buffer;
+	}
+
+	//! The key without the distribution, to compare one engine across them
+	std::string size_key() const
+	{
+		char buffer[64];
+		std::sprintf(buffer, ",%llu,%llu", (unsigned long long)rows, (unsigned long long)cols);
+		return engine + "," + shape + buffer;
+	}
+};
+
+void write_csv(const char* path, const std::vector<result_type>& results)
+{
+	FILE* file = std::fopen(path, "w");
+	if ( file == NULL ) {
+		std::fprintf(stderr, "can not write %s\n", path);
+		std::exit(1);
+	}
+
+	std::fprintf(file, "engine,shape,dist,rows,cols,solves,mean_ns,p50_ns,p90_ns,p99_ns,cost,reference,ok\n");
+	for ( size_t k = 0 ; k < results.size() ; k++ ) {
+		const result_type& r = results[k];
+		std::fprintf(file, "%s,%llu,%.0f,%.0f,%.0f,%.0f,%.17g,%.17g,%d\n", r.key().c_str(),
+			(unsigned long long)r.solves, r.mean_ns, r.p50_ns, r.p90_ns, r.p99_ns, r.cost, r.reference, r.ok ? 1 : 0);
+	}
+
+	std::fclose(file);
+}
+
+void write_json(const char* path, unsigned long long seed, const std::vector<result_type>& results)
+{
+	FILE* file = std::fopen(path, "w");
+	if ( file == NULL ) {
+		std::fprintf(stderr, "can not write %s\n", path);
+		std::exit(1);
+	}
+
+	std::fprintf(file, "{\n  \"seed\": %llu,\n  \"results\": [", seed);
+	for ( size_t k = 0 ; k < results.size() ; k++ ) {
+		const result_type& r = results[k];
+		std::fprintf(file, "%s\n    { \"engine\": \"%s\", \"shape\": \"%s\", \"dist\": \"%s\", "
+			"\"rows\": %llu, \"cols\": %llu, \"solves\": %llu, \"mean_ns\": %.0f, \"p50_ns\": %.0f, "
+			"\"p90_ns\": %.0f, \"p99_ns\": %.0f, \"cost\": %.17g, ", k > 0 ? "," : "",
+			r.engine.c_str(), r.shape.c_str(), r.dist.c_str(), (unsigned long long)r.rows, (unsigned long long)r.cols,
+			(unsigned long long)r.solves, r.mean_ns, r.p50_ns, r.p90_ns, r.p99_ns, r.cost);
+
+		// JSON has no NaN
+		if ( r.reference == r.reference )
+			std::fprintf(file, "\"reference\": %.17g, ", r.reference);
+		else
+			std::fprintf(file, "\"reference\": null, ");
+
+		std::fprintf(file, "\"ok\": %s }", r.ok ? "true" : "false");
+	}
+	std::fprintf(file, "\n  ]\n}\n");
+
+	std::fclose(file);
+}
+
+//! Median latency per case key from a CSV report written by --csv
+std::map<std::string, double> read_baseline(const char* path)
+{
+	std::map<std::string, double> baseline;
+
+	FILE* file = std::fopen(path, "r");
+	if ( file == NULL ) {
+		std::fprintf(stderr, "can not read %s\n", path);
+		std::exit(1);
+	}
+
+	char line[1024];
+	bool header = true;
+	while ( std::fgets(line, sizeof(line), file) != NULL ) {
+		if ( header ) {
+			header = false;
+			continue;
+		}
+
+		// engine,shape,dist,rows,cols,solves,mean_ns,p50_ns,...
+		std::vector<std::string> fields;
+		for ( const char* p = line ; ; ) {
+			const char* end = std::strpbrk(p, ",\r\n");
+			fields.push_back(std::string(p, end ? end : p + std::strlen(p)));
+			if ( end == NULL || *end != ',' )
+				break;
+			p = end + 1;
+		}
+
+		if ( fields.size() >= 8 )
+			baseline[fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3] + "," + fields[4]] =
+				std::atof(fields[7].c_str());
+	}
+
+	std::fclose(file);
+	return baseline;
+}
+
+void usage(const char* name)
+{
+	std::printf("usage: %s [--seed S] [--min N] [--max N] [--engine steps|slack|sap|auction|all]\n"
+		"          [--shape square|tall|wide|row|column|all]\n"
+		"          [--dist int|real|ties|inf|const|inflines|sparse|all] [--budget SECONDS]\n"
+		"          [--check] [--allocations] [--csv FILE] [--json FILE]\n"
+		"          [--baseline FILE] [--tolerance FRACTION] [--floor NS] [--degenerate FACTOR]\n", name);
+}
+
+//! Index of value in names, count for "all" and -1 if unknown
+int lookup(const char* value, const char* const names[], int count)
+{
+	if ( std::strcmp(value, "all") == 0 )
+		return count;
+
+	for ( int i = 0 ; i < count ; i++ ) {
+		if ( std::strcmp(value, names[i]) == 0 )
+			return i;
+	}
+
+	return -1;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned long long seed = 2015;
+	arma::uword min_size = 8,
+		max_size = 4096; // where the O(n^3) engines drift apart
+	double budget = 1.0; // seconds per size before moving on to the next case
+	bool check = false;
+	bool count_allocations = false; // solve after reserve() and fail on any heap allocation
+	const char* csv_path = NULL;
+	const char* json_path = NULL;
+	const char* baseline_path = NULL;
+	double tolerance = 0.1; // allowed slowdown of the median against the baseline
+	double floor_ns = 1000; // medians below are timer noise and not compared
+	double degenerate = 16; // allowed slowdown of ties and const against int of the same case
+
+	const int engine_count = sizeof(engines) / sizeof(engines[0]),
+		shape_count = sizeof(shape_names) / sizeof(shape_names[0]),
+		dist_count = sizeof(distribution_names) / sizeof(distribution_names[0]);
+
+	const char* engine_names[engine_count];
+	for ( int i = 0 ; i < engine_count ; i++ )
+		engine_names[i] = engines[i].name;
+
+	int engine = engine_count,
+		shape = shape_count,
+		dist = dist_count;
+
+	for ( int i = 1 ; i < argc ; i++ ) {
+		const bool has_value = i + 1 < argc;
+
+		if ( std::strcmp(argv[i], "--seed") == 0 && has_value )
+			std::sscanf(argv[++i], "%llu", &seed);
+		else if ( std::strcmp(argv[i], "--min") == 0 && has_value )
+			min_size = std::strtoul(argv[++i], NULL, 10);
+		else if ( std::strcmp(argv[i], "--max") == 0 && has_value )
+			max_size = std::strtoul(argv[++i], NULL, 10);
+		else if ( std::strcmp(argv[i], "--budget") == 0 && has_value )
+			budget = std::atof(argv[++i]);
+		else if ( std::strcmp(argv[i], "--engine") == 0 && has_value )
+			engine = lookup(argv[++i], engine_names, engine_count);
+		else if ( std::strcmp(argv[i], "--shape") == 0 && has_value )
+			shape = lookup(argv[++i], shape_names, shape_count);
+		else if ( std::strcmp(argv[i], "--dist") == 0 && has_value )
+			dist = lookup(argv[++i], distribution_names, dist_count);
+		else if ( std::strcmp(argv[i], "--check") == 0 )
+			check = true;
+		else if ( std::strcmp(argv[i], "--allocations") == 0 )
+			count_allocations = true;
+		else if ( std::strcmp(argv[i], "--csv") == 0 && has_value )
+			csv_path = argv[++i];
+		else if ( std::strcmp(argv[i], "--json") == 0 && has_value )
+			json_path = argv[++i];
+		else if ( std::strcmp(argv[i], "--baseline") == 0 && has_value )
+			baseline_path = argv[++i];
+		else if ( std::strcmp(argv[i], "--tolerance") == 0 && has_value )
+			tolerance = std::atof(argv[++i]);
+		else if ( std::strcmp(argv[i], "--floor") == 0 && has_value )
+			floor_ns = std::atof(argv[++i]);
+		else if ( std::strcmp(argv[i], "--degenerate") == 0 && has_value )
+			degenerate = std::atof(argv[++i]);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+
+		if ( engine < 0 || shape < 0 || dist < 0 ) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::printf("# seed %llu\n", seed);
+	std::printf("%-8s %-7s %-8s %6s %6s %12s %12s %12s %8s %14s %s\n",
+		"engine", "shape", "dist", "rows", "cols", "ns/solve", "p50", "p99", "solves", "cost", "check");
+
+	std::vector<result_type> results;
+	std::map<std::string, double> references; // per problem, shared by the engines
+	int failures = 0;
+
+	for ( int d = 0 ; d < dist_count ; d++ ) {
+		if ( dist != dist_count && dist != d )
+			continue;
+
+		for ( int s = 0 ; s < shape_count ; s++ ) {
+			if ( shape != shape_count && shape != s )
+				continue;
+
+			// Sparse problems have their own solver, run once per shape.
+			const int first = d == SPARSE ? 0 : (engine == engine_count ? 0 : engine),
+				last = d == SPARSE ? 1 : (engine == engine_count ? engine_count : engine + 1);
+
+			for ( int e = first ; e < last ; e++ ) {
+				munkres<double> solver;
+
+				for ( size_t k = 0 ; k < sizeof(sizes) / sizeof(sizes[0]) ; k++ ) {
+					const arma::uword n = sizes[k];
+					if ( n < min_size || n > max_size )
+						continue;
+
+					const arma::uword rows = s == TALL ? 2 * n : (s == ROW ? 1 : n),
+						cols = s == WIDE ? 2 * n : (s == COLUMN ? 1 : n);
+
+					// Every case has its own stream, independent of which cases run.
+					generator gen(seed ^ (0x100000001B3ULL * (n * 64 + s * 8 + d)));
+
+					arma::mat cost;
+					arma::sp_mat sparse;
+					if ( d == SPARSE )
+						sparse = sparse_problem(gen, rows, cols);
+					else
+						cost = dense_problem(gen, rows, cols, distribution_type(d));
+
+					arma::umat assignments;
+					arma::wall_clock timer, total_timer;
+					std::vector<double> samples;
+					double elapsed = 0;
+
+					// Wider sparse matrices are transposed into a new SpMat, reserve() does not cover them.
+					const bool counted = count_allocations && (d != SPARSE || cols <= rows);
+					if ( counted ) {
+						solver.reserve(rows, cols, d == SPARSE ? sparse.n_nonzero : 0);
+						assignments.set_size(std::min(rows, cols), 2);
+					}
+
+					allocations = 0;
+
+					// Repeat until a tenth of the budget is used, at least once.
+					total_timer.tic();
+					do {
+						timer.tic();
+						counting = counted;
+						if ( d == SPARSE )
+							solver.solve(sparse, assignments);
+						else
+							solver.solve(cost, assignments, engines[e].method);
+
+						counting = false;
+						samples.push_back(timer.toc() * 1e9);
+						elapsed = total_timer.toc();
+					} while ( elapsed < 0.1 * budget && samples.size() < 1000000 );
+
+					result_type result;
+					result.engine = d == SPARSE ? "sparse" : engines[e].name;
+					result.shape = shape_names[s];
+					result.dist = distribution_names[d];
+					result.rows = rows;
+					result.cols = cols;
+					result.solves = samples.size();
+
+					double sum = 0;
+					for ( size_t i = 0 ; i < samples.size() ; i++ )
+						sum += samples[i];
+
+					std::sort(samples.begin(), samples.end());
+					result.mean_ns = sum / samples.size();
+					result.p50_ns = percentile(samples, 0.5);
+					result.p90_ns = percentile(samples, 0.9);
+					result.p99_ns = percentile(samples, 0.99);
+
+					result.cost = d == SPARSE ? total_cost(sparse, assignments) : total_cost(cost, assignments);
+					result.reference = std::numeric_limits<double>::quiet_NaN();
+					result.ok = valid(assignments, rows, cols) && result.cost == result.cost;
+
+					if ( check ) {
+						const std::string problem = result.key().substr(result.engine.size());
+						if ( references.find(problem) == references.end() )
+							references[problem] = reference_cost(cost, sparse, d == SPARSE);
+
+						result.reference = references[problem];
+						result.ok = result.ok && matches(result.cost, result.reference);
+					}
+
+					if ( allocations > 0 ) {
+						std::printf("# %llu heap allocations in %llu solves of %s after reserve()\n", allocations,
+							(unsigned long long)result.solves, result.key().c_str());
+						result.ok = false;
+					}
+
+					if ( !result.ok )
+						failures++;
+
+					std::printf("%-8s %-7s %-8s %6llu %6llu %12.0f %12.0f %12.0f %8llu %14.6g %s\n",
+						result.engine.c_str(), shape_names[s], distribution_names[d],
+						(unsigned long long)rows, (unsigned long long)cols, result.mean_ns, result.p50_ns,
+						result.p99_ns, (unsigned long long)result.solves, result.cost,
+						!result.ok ? "FAIL" : (check ? "ok" : "-"));
+					std::fflush(stdout);
+
+					results.push_back(result);
+
+					// Larger sizes would only take longer.
+					if ( elapsed / result.solves > budget )
+						break;
+				}
+			}
+		}
+	}
+
+	// Entry points outside the timed cases, against the same reference.
+	if ( check ) {
+		generator gen(seed ^ 0x5851F42D4C957F2DULL);
+
+		const int wrong = check_fixed<arma::s16, 8>(gen, 100) + check_fixed<arma::s32, 8>(gen, 100);
+		std::printf("# fixed-size s16 and s32 8 x 8, full range: %d of 200 wrong\n", wrong);
+
+		const int wrong_auction = check_auction_s64(gen, 1000);
+		std::printf("# auction s64 2^60 + [0, 16): %d of 1000 wrong\n", wrong_auction);
+		failures += wrong + wrong_auction + check_entry_points(seed, "munkres-bench-mmap.tmp");
+	}
+
+	if ( csv_path != NULL )
+		write_csv(csv_path, results);
+
+	if ( json_path != NULL )
+		write_json(json_path, seed, results);
+
+	// Median against the baseline. Cases missing from it are new, and cases
+	// faster than the floor too noisy, both pass.
+	int regressions = 0;
+	if ( baseline_path != NULL ) {
+		const std::map<std::string, double> baseline = read_baseline(baseline_path);
+
+		for ( size_t k = 0 ; k < results.size() ; k++ ) {
+			const std::map<std::string, double>::const_iterator it = baseline.find(results[k].key());
+			if ( it == baseline.end() || it->second < floor_ns || results[k].p50_ns <= it->second * (1 + tolerance) )
+				continue;
+
+			std::printf("# regression %s: p50 %.0f ns, baseline %.0f ns (+%.0f%%)\n", results[k].key().c_str(),
+				results[k].p50_ns, it->second, 100 * (results[k].p50_ns / it->second - 1));
+			regressions++;
+		}
+	}
+
+	// Tied and constant costs are easy, an engine that takes much longer on
+	// them than on random integers of the same size breaks ties badly.
+	std::map<std::string, double> uniform;
+	for ( size_t k = 0 ; k < results.size() ; k++ ) {
+		if ( results[k].dist == distribution_names[UNIFORM_INT] )
+			uniform[results[k].size_key()] = results[k].p50_ns;
+	}
+
+	for ( size_t k = 0 ; k < results.size() ; k++ ) {
+		if ( results[k].dist != distribution_names[MANY_TIES] && results[k].dist != distribution_names[CONSTANT] )
+			continue;
+
+		const std::map<std::string, double>::const_iterator it = uniform.find(results[k].size_key());
+		if ( it == uniform.end() || it->second < floor_ns || results[k].p50_ns <= it->second * degenerate )
+			continue;
+
+		std::printf("# regression %s: p50 %.0f ns, %.0fx the int case\n", results[k].key().c_str(),
+			results[k].p50_ns, results[k].p50_ns / it->second);
+		regressions++;
+	}
+
+	if ( failures > 0 || regressions > 0 ) {
+		std::printf("# %d failed, %d regressed\n", failures, regressions);
+		return 1;
+	}
+
+	return 0;
+}